@@ -1,8 +1,9 @@
 #!/usr/bin/env python3
+import hashlib
+import json
 import os
 import shutil
 import subprocess
-import random
 
 # Config
 RESOLUTION = "1080p"
@@ -40,85 +41,71 @@ def check_root():
         print("Please run as root (sudo).")
         exit(1)
 
+def file_hash(path):
+    digest = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            digest.update(chunk)
+    return digest.hexdigest()[:16]
+
 def install_themes():
-    print(f"Installing all themes for {RESOLUTION}...")
+    """Store unique : assets communs une seule fois, fonds d'écran nommés par leur hash"""
+    print(f"Installing theme store for {RESOLUTION}...")
     if not os.path.exists(GRUB_THEMES_DIR):
         os.makedirs(GRUB_THEMES_DIR)
 
-    for style_code, style_name in styles.items():
+    # Anciennes installations : une copie complète par style, plus la copie active
+    for style_name in styles.values():
         theme_dir = os.path.join(GRUB_THEMES_DIR, f"dedsec-{style_name}")
-        # print(f"  - Installing {style_name} to {theme_dir}...")
-        
         if os.path.exists(theme_dir):
             shutil.rmtree(theme_dir)
-        os.makedirs(theme_dir)
-
-        # Assets paths (relative to where script is run, inside dedsec-theme dir)
-        bg_path = f"assets/backgrounds/{style_name.lower()}-{RESOLUTION}.png"
-        icons_path = f"assets/icons-{RESOLUTION}/{ICON_THEME}/"
-        fonts_path = f"assets/fonts/{RESOLUTION}/"
-        base_path = f"base/{RESOLUTION}/"
-
-        shutil.copy(bg_path, os.path.join(theme_dir, "background.png"))
-        shutil.copytree(icons_path, os.path.join(theme_dir, "icons"))
-        shutil.copytree(fonts_path, theme_dir, dirs_exist_ok=True)
-        shutil.copytree(base_path, theme_dir, dirs_exist_ok=True)
-
-    print("All themes installed.")
-
-def setup_initial_theme():
-    print("Setting up initial theme directory (Copying because FAT32 usually doesn't support symlinks)...")
-    first_style = random.choice(list(styles.values()))
-    target = os.path.join(GRUB_THEMES_DIR, f"dedsec-{first_style}")
-    
-    # Remove if exists (it might be a broken symlink from previous run or a dir)
     if os.path.islink(LINK_PATH):
         os.unlink(LINK_PATH)
     elif os.path.exists(LINK_PATH):
         shutil.rmtree(LINK_PATH)
-            
-    shutil.copytree(target, LINK_PATH)
-    print(f"Current theme directory created from: {target}")
+
+    # Assets paths (relative to where script is run, inside dedsec-theme dir)
+    icons_path = f"assets/icons-{RESOLUTION}/{ICON_THEME}/"
+    fonts_path = f"assets/fonts/{RESOLUTION}/"
+    base_path = f"base/{RESOLUTION}/"
+
+    os.makedirs(os.path.join(LINK_PATH, "backgrounds"))
+    shutil.copytree(icons_path, os.path.join(LINK_PATH, "icons"))
+    shutil.copytree(fonts_path, LINK_PATH, dirs_exist_ok=True)
+    shutil.copytree(base_path, LINK_PATH, dirs_exist_ok=True)
+    # theme.txt est régénéré par le rotator à partir de ce modèle
+    os.rename(os.path.join(LINK_PATH, "theme.txt"), os.path.join(LINK_PATH, "theme.txt.in"))
+
+    manifest = {}
+    for style_name in styles.values():
+        bg_path = f"assets/backgrounds/{style_name.lower()}-{RESOLUTION}.png"
+        stored = f"backgrounds/{file_hash(bg_path)}.png"
+        if not os.path.exists(os.path.join(LINK_PATH, stored)):
+            shutil.copy(bg_path, os.path.join(LINK_PATH, stored))
+        manifest[style_name] = stored
+
+    with open(os.path.join(LINK_PATH, "styles.json"), "w") as f:
+        json.dump(manifest, f, indent=2)
+    print(f"{len(manifest)} styles installed, {len(set(manifest.values()))} backgrounds stored.")
 
 def install_rotator_script():
     print("Installing rotator script...")
-    script_content = f'''#!/bin/bash
-# Select a random dedsec theme folder
-THEMES_DIR="{GRUB_THEMES_DIR}"
-LINK_NAME="{LINK_NAME}"
-LINK_PATH="{LINK_PATH}"
-
-# Find all dedsec-* folders (excluding the target dir itself and other themes)
-# We assume folders are named dedsec-*
-THEMES=($(find "$THEMES_DIR" -maxdepth 1 -type d -name "dedsec-*" ! -name "$LINK_NAME"))
-
-if [ ${{#THEMES[@]}} -eq 0 ]; then
-    echo "No themes found."
-    exit 1
-fi
-
-# Pick random index
-RANDOM_INDEX=$((RANDOM % ${{#THEMES[@]}}))
-SELECTED="${{THEMES[$RANDOM_INDEX]}}"
-
-echo "Rotating GRUB theme to: $(basename "$SELECTED")"
-
-# Remove old content
-rm -rf "$LINK_PATH"
-# Copy new content
-cp -r "$SELECTED" "$LINK_PATH"
-'''
     rotator_path = "/usr/local/bin/grub-theme-rotator"
-    with open(rotator_path, "w") as f:
-        f.write(script_content)
+    source = os.path.join(os.path.dirname(os.path.abspath(__file__)), "grub-theme-rotator")
+    shutil.copy(source, rotator_path)
     os.chmod(rotator_path, 0o755)
     print(f"Rotator script installed to {rotator_path}")
 
+def setup_initial_theme():
+    print("Selecting initial theme...")
+    subprocess.run(["/usr/local/bin/grub-theme-rotator"], check=True)
+
 def install_service():
     print("Installing systemd service...")
     service_content = '''[Unit]
 Description=Rotate GRUB Theme on Boot
 Before=shutdown.target reboot.target halt.target
+RequiresMountsFor=/boot
 
 [Service]
 Type=oneshot
@@ -165,8 +152,8 @@ def update_grub_config():
 if __name__ == "__main__":
     check_root()
     install_themes()
-    setup_initial_theme()
     install_rotator_script()
+    setup_initial_theme()
     install_service()
     update_grub_config()
     print("\nSUCCESS! Random theme configured.")
@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""
+Historique du presse-papier - Stockage indexé
+Usage:
+  clipboard_history.py store   # lit le contenu sur stdin (wl-paste --watch)
+  clipboard_history.py pick    # menu wofi (Super+V)
+  clipboard_history.py list    # liste numérotée sur stdout
+  clipboard_history.py wipe    # efface l'historique
+
+Le stockage est en ajout seul et lu par mmap, le menu n'a rien à reconstruire :
+- data      : contenus concaténés, jamais réécrits
+- index     : une entrée de taille fixe par contenu (offset, taille, hash, supprimé)
+- previews  : un aperçu de PREVIEW_SIZE octets par entrée, calculé à l'enregistrement
+
+Ouvrir le menu revient à parcourir au plus les entrées de l'index depuis la fin et à
+envoyer les aperçus déjà prêts à wofi (recherche floue via --matching=fuzzy). Supprimer
+une entrée ne fait que marquer son index ; les fichiers sont compactés quand les entrées
+mortes dépassent COMPACT_FACTOR fois MAX_ITEMS.
+"""
+import fcntl
+import html
+import mmap
+import os
+import re
+import struct
+import subprocess
+import sys
+import time
+import zlib
+
+# Configuration
+MAX_ITEMS = 200
+COMPACT_FACTOR = 4
+PREVIEW_SIZE = 128
+STORE_DIR = os.path.join(os.environ.get("XDG_CACHE_HOME", os.path.expanduser("~/.cache")), "clipboard_history")
+STYLE_FILE = os.path.expanduser("~/.config/wofi/clipboard-style.css")
+ACTION_STYLE_FILE = os.path.expanduser("~/.config/wofi/action-style.css")
+LOG_FILE = "/tmp/clipboard_history.log"
+
+DATA_FILE = os.path.join(STORE_DIR, "data")
+INDEX_FILE = os.path.join(STORE_DIR, "index")
+PREVIEWS_FILE = os.path.join(STORE_DIR, "previews")
+LOCK_FILE = os.path.join(STORE_DIR, "lock")
+
+# offset (u64), taille (u32), crc32 (u32), supprimé (u8)
+INDEX_ENTRY = struct.Struct("<QIIB3x")
+
+WIPE_ALL = "🗑️ Tout supprimer"
+SEPARATOR = "─────────────"
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
+
+
+def notify(title, message):
+    subprocess.Popen(["notify-send", title, message])
+
+
+def make_preview(content):
+    """Espaces réduits, échappé pour Pango, tronqué sans couper un caractère UTF-8 ni une entité"""
+    text = " ".join(content.decode("utf-8", "replace").split())
+    preview = html.escape(text, quote=False).encode()
+    if len(preview) > PREVIEW_SIZE:
+        head = preview[:PREVIEW_SIZE - 3].decode("utf-8", "ignore")
+        preview = re.sub(r"&[^;]*$", "", head).encode() + b"..."
+    return preview.ljust(PREVIEW_SIZE, b"\0")
+
+
+class Store:
+    def __init__(self, writable=False):
+        os.makedirs(STORE_DIR, exist_ok=True)
+        self.lock = open(LOCK_FILE, "a")
+        fcntl.flock(self.lock, fcntl.LOCK_EX if writable else fcntl.LOCK_SH)
+        for path in (DATA_FILE, INDEX_FILE, PREVIEWS_FILE):
+            if not os.path.exists(path):
+                open(path, "wb").close()
+        # data est en ajout seul ; index et previews sont écrits à une position donnée (pas de "a", qui ignore seek)
+        self.data = open(DATA_FILE, "a+b" if writable else "rb")
+        self.index = open(INDEX_FILE, "r+b" if writable else "rb")
+        self.previews = open(PREVIEWS_FILE, "r+b" if writable else "rb")
+        self.writable = writable
+
+    def close(self):
+        for f in (self.data, self.index, self.previews, self.lock):
+            f.close()
+
+    @staticmethod
+    def map(f, writable=False):
+        size = os.fstat(f.fileno()).st_size
+        if size == 0:
+            return b""
+        return mmap.mmap(f.fileno(), size, access=mmap.ACCESS_WRITE if writable else mmap.ACCESS_READ)
+
+    def entries(self, index_map):
+        """(numéro, offset, taille, crc, supprimé) du plus récent au plus ancien"""
+        for n in range(len(index_map) // INDEX_ENTRY.size - 1, -1, -1):
+            yield (n, *INDEX_ENTRY.unpack_from(index_map, n * INDEX_ENTRY.size))
+
+    def live(self, limit=MAX_ITEMS):
+        index_map = self.map(self.index)
+        return [(n, offset, length, crc) for n, offset, length, crc, deleted in self.entries(index_map)
+                if not deleted][:limit]
+
+    def find(self, length, crc):
+        """(numéro, offset) de l'entrée vivante de ce contenu : un compactage entre le menu et l'action
+        change numéros et offsets, pas la taille ni le hash (un contenu n'est présent qu'une fois)"""
+        for n, offset, entry_length, entry_crc in self.live(limit=None):
+            if entry_length == length and entry_crc == crc:
+                return n, offset
+        return None
+
+    def content(self, offset, length):
+        data_map = self.map(self.data)
+        return bytes(data_map[offset:offset + length])
+
+    def preview(self, previews_map, n):
+        return previews_map[n * PREVIEW_SIZE:(n + 1) * PREVIEW_SIZE].rstrip(b"\0").decode("utf-8", "replace")
+
+    def mark_deleted(self, numbers):
+        index_map = self.map(self.index, writable=True)
+        for n in numbers:
+            index_map[n * INDEX_ENTRY.size + 16] = 1
+        if index_map:
+            index_map.flush()
+
+    def store(self, content):
+        crc = zlib.crc32(content)
+        index_map = self.map(self.index)
+        live = []
+        duplicates = []
+        for n, offset, length, entry_crc, deleted in self.entries(index_map):
+            if deleted:
+                continue
+            # Même contenu déjà présent : il remonte en tête
+            if entry_crc == crc and length == len(content) and self.content(offset, length) == content:
+                duplicates.append(n)
+            else:
+                live.append(n)
+        total = len(index_map) // INDEX_ENTRY.size
+        self.mark_deleted(duplicates + live[MAX_ITEMS - 1:])
+
+        self.data.seek(0, os.SEEK_END)
+        offset = self.data.tell()
+        self.data.write(content)
+        self.previews.seek(total * PREVIEW_SIZE)
+        self.previews.write(make_preview(content))
+        self.index.seek(total * INDEX_ENTRY.size)
+        self.index.write(INDEX_ENTRY.pack(offset, len(content), crc, 0))
+        for f in (self.data, self.previews, self.index):
+            f.flush()
+
+        if total + 1 > COMPACT_FACTOR * MAX_ITEMS:
+            self.compact()
+
+    def compact(self):
+        """Réécrit les trois fichiers avec les seules entrées vivantes (rare)"""
+        entries = list(reversed(self.live()))
+        previews_map = self.map(self.previews)
+        contents = [(self.content(offset, length), previews_map[n * PREVIEW_SIZE:(n + 1) * PREVIEW_SIZE])
+                    for n, offset, length, _crc in entries]
+        with open(DATA_FILE + ".new", "wb") as data, open(INDEX_FILE + ".new", "wb") as index, \
+                open(PREVIEWS_FILE + ".new", "wb") as previews:
+            for content, preview in contents:
+                index.write(INDEX_ENTRY.pack(data.tell(), len(content), zlib.crc32(content), 0))
+                data.write(content)
+                previews.write(preview)
+        for path in (DATA_FILE, INDEX_FILE, PREVIEWS_FILE):
+            os.replace(path + ".new", path)
+        log(f"Compactage : {len(entries)} entrées conservées")
+
+    def wipe(self):
+        for path in (DATA_FILE, INDEX_FILE, PREVIEWS_FILE):
+            open(path, "wb").close()
+
+
+def wofi(options, style, width, height, prompt=None, search=True):
+    cmd = ["wofi", "--dmenu", "--style", style, "--width", str(width), "--height", str(height),
+           "--sort-order=default", "--allow-markup", "--matching=fuzzy"]
+    if prompt:
+        cmd += ["--prompt", prompt]
+    if not search:
+        cmd.append("--hide-search")
+    return subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True), options
+
+
+def ask(proc_options):
+    proc, options = proc_options
+    stdout, _ = proc.communicate("\n".join(options))
+    return stdout.strip() if proc.returncode == 0 else None
+
+
+def ensure_watcher():
+    """Vérification du service wl-paste (scan de /proc, sans pgrep)"""
+    for pid in filter(str.isdigit, os.listdir("/proc")):
+        try:
+            with open(f"/proc/{pid}/comm") as f:
+                if f.read().strip() == "wl-paste":
+                    return
+        except OSError:
+            pass
+    notify("⚠️ Presse-papier", "Service arrêté, redémarrage...")
+    subprocess.Popen(["wl-paste", "-t", "text", "--watch", sys.executable, os.path.abspath(__file__), "store"],
+                     start_new_session=True)
+
+
+def pick():
+    start = time.monotonic()
+    ensure_watcher()
+
+    store = Store()
+    entries = store.live()
+    previews_map = store.map(store.previews)
+    total = len(entries)
+    numbers = {}
+    lines = []
+    for rank, (n, _offset, length, crc) in enumerate(entries):
+        number = total - rank
+        numbers[str(number)] = (length, crc)
+        lines.append(f"{number}. {store.preview(previews_map, n)}")
+    store.close()
+    if not lines:
+        lines = ["0. (Historique vide)"]
+
+    # Menu simple : items en premier, puis actions
+    menu = wofi(lines + [SEPARATOR, WIPE_ALL], STYLE_FILE, 550, 400, prompt="📋 Presse-papier")
+    log(f"Menu prêt : {total} entrées en {(time.monotonic() - start) * 1000:.1f} ms")
+    selection = ask(menu)
+    if not selection:
+        return
+
+    if selection == WIPE_ALL:
+        confirm = ask(wofi(["❌ Annuler", "✅ Confirmer"], ACTION_STYLE_FILE, 280, 150, search=False))
+        if confirm == "✅ Confirmer":
+            store = Store(writable=True)
+            store.wipe()
+            store.close()
+            notify("🗑️", "Historique effacé")
+        return
+
+    number = selection.split(".", 1)[0]
+    if number not in numbers:
+        return
+    length, crc = numbers[number]
+
+    # Menu d'action avec boutons grands
+    action = ask(wofi(["📋 Copier", "🗑️ Supprimer"], ACTION_STYLE_FILE, 300, 180, search=False))
+    if action not in ("📋 Copier", "🗑️ Supprimer"):
+        return
+
+    # Entrée retrouvée sous le verrou : le menu est resté ouvert sans, l'historique a pu changer
+    store = Store(writable=action == "🗑️ Supprimer")
+    found = store.find(length, crc)
+    if found and action == "📋 Copier":
+        content = store.content(found[1], length)
+        found = found if zlib.crc32(content) == crc else None
+    elif found:
+        store.mark_deleted([found[0]])
+    store.close()
+    if not found:
+        notify("📋", "Entrée disparue de l'historique")
+    elif action == "📋 Copier":
+        subprocess.run(["wl-copy"], input=content)
+        notify("📋", "Copié!")
+    else:
+        notify("🗑️", "Supprimé")
+
+
+def main():
+    command = sys.argv[1] if len(sys.argv) > 1 else "pick"
+    if command == "store":
+        content = sys.stdin.buffer.read()
+        if content.strip():
+            store = Store(writable=True)
+            store.store(content)
+            store.close()
+    elif command == "list":
+        store = Store()
+        previews_map = store.map(store.previews)
+        entries = store.live()
+        for rank, (n, _offset, _length, _crc) in enumerate(entries):
+            print(f"{len(entries) - rank}. {store.preview(previews_map, n)}")
+        store.close()
+    elif command == "wipe":
+        store = Store(writable=True)
+        store.wipe()
+        store.close()
+    elif command == "pick":
+        pick()
+    else:
+        print(__doc__)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,477 @@
+#!/usr/bin/env python3
+"""
+Broker d'événements Hyprland partagé par les helpers du bureau
+Usage:
+  hypr_events.py daemon                     # lancé par session_startup.py (ou par le premier client)
+  hypr_events.py subscribe <filtres> [nom]  # flux JSON, une ligne par événement (filtres séparés par ,)
+  hypr_events.py query <état>               # workspace, clients, monitors, activewindow ou state
+  hypr_events.py stats                      # latence de livraison par abonné
+
+Une seule connexion au socket2 de Hyprland pour tous les helpers. Chaque ligne
+"nom>>val1,val2" est découpée une fois en enregistrement typé (EVENT_FIELDS, adresses en
+0x..., ids en entiers, openwindow complété par le PID et le workspace de la fenêtre) puis
+envoyée en JSON aux abonnés dont un filtre est un préfixe du nom de l'événement :
+"workspace" reçoit workspace et workspacev2, "monitor" tous les monitor*, "*" tout.
+
+L'état (workspace actif, clients, moniteurs, fenêtre active) est chargé une fois au
+démarrage puis tenu à jour par les événements : les requêtes query y répondent sans
+hyprctl ni aller-retour vers Hyprland.
+
+Les envois aux abonnés sont non bloquants : un abonné lent (ou gelé) accumule ses
+événements jusqu'à MAX_BACKLOG puis est déconnecté, sans retarder les autres. La latence
+de livraison va de la lecture de la ligne sur le socket2 à son écriture complète dans le
+socket de l'abonné. Le broker s'arrête avec Hyprland (fin du socket2).
+
+Dépendances: python-gobject
+"""
+import collections
+import fcntl
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+from gi.repository import GLib
+
+# Configuration
+RUNTIME_DIR = os.environ.get("XDG_RUNTIME_DIR", "/run/user/%d" % os.getuid())
+SOCKET_PATH = os.path.join(RUNTIME_DIR, "hypr_events.sock")
+LOCK_PATH = os.path.join(RUNTIME_DIR, "hypr_events.lock")
+LOG_FILE = "/tmp/hypr_events.log"
+HYPR_DIR = os.path.join(RUNTIME_DIR, "hypr", os.environ.get("HYPRLAND_INSTANCE_SIGNATURE", ""))
+MAX_BACKLOG = 1 << 20        # Octets en attente par abonné avant déconnexion
+CONNECT_TIMEOUT = 2.0        # Attente du broker par les clients (secondes)
+QUERIES = ("workspace", "clients", "monitors", "activewindow", "state")
+
+# Champs des événements du socket2 ; le dernier garde ses virgules (titres)
+EVENT_FIELDS = {
+    "workspace": ("name",),
+    "workspacev2": ("id", "name"),
+    "focusedmon": ("monitor", "workspace"),
+    "focusedmonv2": ("monitor", "workspace_id"),
+    "activewindow": ("class", "title"),
+    "activewindowv2": ("address",),
+    "openwindow": ("address", "workspace", "class", "title"),
+    "closewindow": ("address",),
+    "movewindow": ("address", "workspace"),
+    "movewindowv2": ("address", "workspace_id", "workspace"),
+    "windowtitle": ("address",),
+    "windowtitlev2": ("address", "title"),
+    "createworkspace": ("name",),
+    "createworkspacev2": ("id", "name"),
+    "destroyworkspace": ("name",),
+    "destroyworkspacev2": ("id", "name"),
+    "monitoradded": ("name",),
+    "monitoraddedv2": ("id", "name", "description"),
+    "monitorremoved": ("name",),
+    "monitorremovedv2": ("id", "name", "description"),
+    "openlayer": ("namespace",),
+    "closelayer": ("namespace",),
+    "fullscreen": ("state",),
+}
+INT_FIELDS = ("id", "workspace_id", "state")
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
+
+
+def hypr_request(command):
+    """Requête sur le socket IPC de Hyprland (équivalent de hyprctl, sans fork)"""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(os.path.join(HYPR_DIR, ".socket.sock"))
+        sock.sendall(command.encode())
+        data = b""
+        while chunk := sock.recv(4096):
+            data += chunk
+    return data.decode()
+
+
+def parse_event(line):
+    """Ligne du socket2 -> enregistrement typé"""
+    name, _, payload = line.partition(">>")
+    fields = EVENT_FIELDS.get(name)
+    if fields is None:
+        return {"event": name, "data": payload}
+    record = {"event": name}
+    record.update(zip(fields, payload.split(",", len(fields) - 1)))
+    for key in INT_FIELDS:
+        if key in record:
+            try:
+                record[key] = int(record[key])
+            except ValueError:
+                pass  # Workspaces spéciaux sans id numérique
+    if "address" in record:
+        record["address"] = "0x" + record["address"]
+    return record
+
+
+class HyprState:
+    """Copie de l'état de Hyprland tenue à jour par les événements"""
+
+    def __init__(self):
+        self.requests = 0
+        self.workspace = self.request("j/activeworkspace")
+        self.monitors = self.request("j/monitors")
+        self.clients = {client["address"]: client for client in self.request("j/clients")}
+        self.activewindow = self.request("j/activewindow").get("address")
+
+    def request(self, command):
+        self.requests += 1
+        return json.loads(hypr_request(command))
+
+    def query(self, what):
+        if what == "workspace":
+            return self.workspace
+        if what == "clients":
+            return list(self.clients.values())
+        if what == "monitors":
+            return self.monitors
+        if what == "activewindow":
+            return self.clients.get(self.activewindow, {})
+        return {"workspace": self.workspace, "monitors": self.monitors,
+                "clients": list(self.clients.values()), "activewindow": self.activewindow}
+
+    def apply(self, record):
+        """Met l'état à jour ; complète openwindow avec le PID et le workspace de la fenêtre"""
+        event = record["event"]
+        if event == "workspacev2":
+            self.workspace = dict(self.workspace, id=record["id"], name=record["name"])
+        elif event == "focusedmon":
+            self.workspace = self.request("j/activeworkspace")
+        elif event == "activewindowv2":
+            self.activewindow = record["address"]
+        elif event == "openwindow":
+            client = next((c for c in self.request("j/clients") if c["address"] == record["address"]), None)
+            if client is None:  # Déjà refermée
+                client = {"address": record["address"], "class": record["class"], "title": record["title"],
+                          "workspace": {"name": record["workspace"]}, "pid": None}
+            self.clients[record["address"]] = client
+            record["pid"] = client["pid"]
+            record["workspace_id"] = client["workspace"].get("id")
+        elif event == "closewindow":
+            self.clients.pop(record["address"], None)
+        elif event == "movewindowv2" and record["address"] in self.clients:
+            self.clients[record["address"]]["workspace"] = {"id": record["workspace_id"], "name": record["workspace"]}
+        elif event == "windowtitlev2" and record["address"] in self.clients:
+            self.clients[record["address"]]["title"] = record["title"]
+        elif event.startswith(("monitoradded", "monitorremoved")):
+            self.monitors = self.request("j/monitors")
+
+
+class Subscriber:
+    """Abonné : filtres, file d'envoi non bloquante et latence de livraison"""
+
+    def __init__(self, conn, filters, name):
+        self.conn = conn
+        self.filters = tuple(filters)
+        self.name = name
+        self.out = bytearray()
+        self.pending = collections.deque()   # (octets cumulés en fin d'événement, lecture socket2)
+        self.queued = 0
+        self.sent = 0
+        self.watch = 0
+        self.delivered = 0
+        self.latency_total = 0.0
+        self.latency_max = 0.0
+        self.backlog_max = 0
+        conn.setblocking(False)
+
+    def wants(self, event):
+        return "*" in self.filters or event.startswith(self.filters)
+
+    def push(self, line, received):
+        """False si l'abonné doit être déconnecté"""
+        self.out += line
+        self.queued += len(line)
+        self.pending.append((self.queued, received))
+        self.backlog_max = max(self.backlog_max, len(self.out))
+        if len(self.out) > MAX_BACKLOG:
+            log(f"Abonné {self.name} : {len(self.out)} octets en attente, déconnecté")
+            return False
+        if self.watch:
+            return True  # Envoi déjà en attente de place dans le socket
+        return self.flush()
+
+    def flush(self):
+        try:
+            written = self.conn.send(self.out)
+        except BlockingIOError:
+            written = 0
+        except OSError:
+            return False
+        del self.out[:written]
+        self.sent += written
+        now = time.monotonic()
+        while self.pending and self.pending[0][0] <= self.sent:
+            latency = now - self.pending.popleft()[1]
+            self.delivered += 1
+            self.latency_total += latency
+            self.latency_max = max(self.latency_max, latency)
+        if self.out and not self.watch:
+            self.watch = GLib.io_add_watch(self.conn, GLib.PRIORITY_DEFAULT, GLib.IO_OUT, self.on_writable)
+        return True
+
+    def on_writable(self, _conn, _condition):
+        self.watch = 0
+        if not self.flush():
+            self.close()
+        return GLib.SOURCE_REMOVE
+
+    def close(self):
+        if self.watch:
+            GLib.source_remove(self.watch)
+            self.watch = 0
+        self.conn.close()
+
+    def stats(self):
+        return {
+            "name": self.name,
+            "filters": list(self.filters),
+            "delivered": self.delivered,
+            "avg_latency_ms": round(self.latency_total * 1000 / self.delivered, 3) if self.delivered else 0,
+            "max_latency_ms": round(self.latency_max * 1000, 3),
+            "backlog_bytes": len(self.out),
+            "max_backlog_bytes": self.backlog_max,
+        }
+
+
+class Broker:
+    def __init__(self, events, loop):
+        self.events = events
+        self.loop = loop
+        self.buffer = b""
+        self.state = HyprState()
+        self.subscribers = []
+        self.received = collections.Counter()
+        self.parse_time = 0.0
+        self.started = time.monotonic()
+        GLib.io_add_watch(events, GLib.PRIORITY_DEFAULT, GLib.IO_IN | GLib.IO_HUP, self.on_events)
+
+    def on_events(self, _events, _condition):
+        data = self.events.recv(65536)
+        if not data:
+            log("Socket2 fermé (fin de Hyprland), arrêt")
+            self.loop.quit()
+            return GLib.SOURCE_REMOVE
+        received = time.monotonic()
+        self.buffer += data
+        *lines, self.buffer = self.buffer.split(b"\n")
+        for line in lines:
+            record = parse_event(line.decode(errors="replace"))
+            record["time"] = round(time.time(), 3)
+            try:
+                self.state.apply(record)
+            except (OSError, ValueError) as e:
+                log(f"{record['event']} : état non mis à jour ({e})")
+            self.received[record["event"]] += 1
+            targets = [s for s in self.subscribers if s.wants(record["event"])]
+            if targets:
+                encoded = (json.dumps(record, ensure_ascii=False) + "\n").encode()
+                for subscriber in targets:
+                    if not subscriber.push(encoded, received):
+                        self.drop(subscriber)
+        self.parse_time += time.monotonic() - received
+        return GLib.SOURCE_CONTINUE
+
+    def drop(self, subscriber):
+        if subscriber in self.subscribers:
+            self.subscribers.remove(subscriber)
+            subscriber.close()
+            log(f"Abonné {subscriber.name} parti ({subscriber.delivered} événements)")
+
+    def on_subscriber_hup(self, _conn, _condition, subscriber):
+        self.drop(subscriber)
+        return GLib.SOURCE_REMOVE
+
+    def on_connection(self, server, _condition):
+        conn, _ = server.accept()
+        try:
+            conn.settimeout(1.0)
+            request = conn.recv(1024).decode().split()
+            conn.settimeout(None)
+        except (OSError, UnicodeDecodeError):
+            conn.close()
+            return GLib.SOURCE_CONTINUE
+
+        command, argument, name = (request + ["", "", ""])[:3]
+        if command == "subscribe" and argument:
+            # Accusé de réception : le client sait qu'aucun événement suivant ne sera perdu
+            try:
+                conn.sendall((json.dumps({"subscribed": argument.split(",")}) + "\n").encode())
+            except OSError:
+                conn.close()
+                return GLib.SOURCE_CONTINUE
+            subscriber = Subscriber(conn, argument.split(","), name or f"client-{conn.fileno()}")
+            self.subscribers.append(subscriber)
+            # Lecture côté abonné = fermeture (il n'envoie rien d'autre)
+            GLib.io_add_watch(conn, GLib.PRIORITY_DEFAULT, GLib.IO_IN | GLib.IO_HUP | GLib.IO_ERR,
+                              self.on_subscriber_hup, subscriber)
+            log(f"Abonné {subscriber.name} : {argument}")
+            return GLib.SOURCE_CONTINUE
+
+        if command == "query" and argument in QUERIES:
+            reply = self.state.query(argument)
+        elif command == "stats":
+            reply = self.stats()
+        else:
+            reply = {"error": f"requête inconnue : {' '.join(request)}"}
+        try:
+            conn.sendall((json.dumps(reply, ensure_ascii=False) + "\n").encode())
+        except OSError:
+            pass
+        conn.close()
+        return GLib.SOURCE_CONTINUE
+
+    def stats(self):
+        events = sum(self.received.values())
+        return {
+            "uptime_s": round(time.monotonic() - self.started),
+            "events": events,
+            "by_event": dict(self.received.most_common()),
+            "avg_parse_us": round(self.parse_time * 1e6 / events, 1) if events else 0,
+            "hyprland_requests": self.state.requests,
+            "subscribers": [s.stats() for s in self.subscribers],
+        }
+
+
+def run_daemon():
+    lock = open(LOCK_PATH, "w")
+    try:
+        fcntl.flock(lock, fcntl.LOCK_EX | fcntl.LOCK_NB)
+    except OSError:
+        return 0  # Déjà lancé
+
+    events = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        events.connect(os.path.join(HYPR_DIR, ".socket2.sock"))
+    except OSError as e:
+        log(f"Socket2 Hyprland indisponible ({e})")
+        return 1
+
+    if os.path.exists(SOCKET_PATH):
+        os.unlink(SOCKET_PATH)
+    server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    server.bind(SOCKET_PATH)
+    server.listen(16)
+
+    log("=== Démarrage broker d'événements ===")
+    loop = GLib.MainLoop()
+    try:
+        broker = Broker(events, loop)
+    except (OSError, ValueError) as e:
+        log(f"État initial de Hyprland illisible ({e})")
+        os.unlink(SOCKET_PATH)
+        return 1
+    GLib.io_add_watch(server, GLib.PRIORITY_DEFAULT, GLib.IO_IN, broker.on_connection)
+    for sig in (2, 15):  # SIGINT, SIGTERM
+        GLib.unix_signal_add(GLib.PRIORITY_DEFAULT, sig, loop.quit)
+    loop.run()
+
+    for subscriber in broker.subscribers:
+        s = subscriber.stats()
+        log(f"{s['name']}: {s['delivered']} événements, latence moyenne {s['avg_latency_ms']} ms, "
+            f"max {s['max_latency_ms']} ms")
+        subscriber.close()
+    os.unlink(SOCKET_PATH)
+    log("=== Arrêt broker d'événements ===")
+    return 0
+
+
+# --- Côté client ---
+
+def connect(spawn=True):
+    """Connexion au broker, lancé à la demande si absent"""
+    deadline = time.monotonic() + CONNECT_TIMEOUT
+    spawned = False
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(SOCKET_PATH)
+            return sock
+        except OSError:
+            sock.close()
+        if not spawn or time.monotonic() > deadline:
+            raise ConnectionError("broker d'événements Hyprland injoignable")
+        if not spawned:
+            subprocess.Popen([sys.executable, os.path.abspath(__file__), "daemon"],
+                             stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                             start_new_session=True)
+            spawned = True
+        time.sleep(0.05)
+
+
+def request(line):
+    with connect() as sock:
+        sock.sendall(line.encode() + b"\n")
+        data = b""
+        while chunk := sock.recv(65536):
+            data += chunk
+    return json.loads(data)
+
+
+def query(what):
+    """État en cache du broker (voir QUERIES)"""
+    return request(f"query {what}")
+
+
+class Subscription:
+    """Flux d'événements filtrés, utilisable dans un selector (fileno)"""
+
+    def __init__(self, filters, name, spawn=True):
+        self.sock = connect(spawn)
+        self.sock.sendall(f"subscribe {','.join(filters)} {name}\n".encode())
+        # Attente de l'accusé : les événements qui suivent le retour sont tous reçus
+        self.buffer = b""
+        while b"\n" not in self.buffer:
+            data = self.sock.recv(4096)
+            if not data:
+                raise ConnectionError("abonnement refusé par le broker")
+            self.buffer += data
+        self.buffer = self.buffer.split(b"\n", 1)[1]
+
+    def fileno(self):
+        return self.sock.fileno()
+
+    def read(self):
+        """Événements disponibles (bloque si aucun), None quand le broker s'arrête"""
+        data = self.sock.recv(65536)
+        if not data:
+            return None
+        self.buffer += data
+        *lines, self.buffer = self.buffer.split(b"\n")
+        return [json.loads(line) for line in lines]
+
+    def close(self):
+        self.sock.close()
+
+
+def main():
+    command = sys.argv[1] if len(sys.argv) > 1 else ""
+    if command == "daemon":
+        return run_daemon()
+    try:
+        if command == "subscribe" and len(sys.argv) > 2:
+            subscription = Subscription(sys.argv[2].split(","), sys.argv[3] if len(sys.argv) > 3 else "cli")
+            while (records := subscription.read()) is not None:
+                for record in records:
+                    print(json.dumps(record, ensure_ascii=False), flush=True)
+            return 0
+        if command == "query" and len(sys.argv) > 2 and sys.argv[2] in QUERIES:
+            print(json.dumps(query(sys.argv[2]), indent=2, ensure_ascii=False))
+            return 0
+        if command == "stats":
+            print(json.dumps(request("stats"), indent=2, ensure_ascii=False))
+            return 0
+    except (ConnectionError, OSError) as e:
+        print(f"Erreur : {e}", file=sys.stderr)
+        return 1
+    print(__doc__)
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
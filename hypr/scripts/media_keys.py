@@ -0,0 +1,380 @@
+#!/usr/bin/env python3
+"""
+Daemon volume / luminosité - Une seule connexion, pas de fork par appui
+Commandes (une par ligne) écrites dans FIFO_PATH :
+  volume output +5     volume input -1
+  mute output          mute input
+  brightness +5        brightness -5
+
+Les touches de hyprland.conf et les modules waybar écrivent directement dans le FIFO
+(`echo ... 1<> fifo` : ouverture en lecture/écriture, jamais bloquante même si le daemon
+est arrêté). Le daemon garde :
+- un contexte PulseAudio (pipewire-pulse) intégré à la boucle GLib (libpulse-mainloop-glib)
+- une connexion D-Bus système vers logind (SetBrightness, comme brightnessctl sans root)
+- une connexion D-Bus session vers le serveur de notifications
+
+Les appuis arrivés pendant qu'un réglage est en cours sont cumulés et appliqués en un seul
+réglage : une touche maintenue ne fait plus une requête par répétition. Waybar suit déjà
+les changements par lui-même (événements PulseAudio, inotify sur le backlight).
+
+Dépendances: python-gobject, libpulse
+"""
+import ctypes
+import os
+import stat
+import time
+from ctypes import CFUNCTYPE, POINTER, Structure, c_char_p, c_int, c_uint8, c_uint32, c_void_p
+
+from gi.repository import Gio, GLib
+
+# Configuration
+FIFO_PATH = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "media_keys.fifo")
+LOG_FILE = "/tmp/media_keys.log"
+VOLUME_MAX = 100              # Équivalent de wpctl -l 1
+BRIGHTNESS_EXPONENT = 4       # Équivalent de brightnessctl -e4
+BRIGHTNESS_MIN = 2            # Équivalent de brightnessctl -n2
+BACKLIGHT_DIR = "/sys/class/backlight"
+RECONNECT_DELAY = 1           # Reconnexion à PulseAudio après un redémarrage (secondes)
+
+PA_VOLUME_NORM = 0x10000
+PA_CONTEXT_READY = 4
+PA_CONTEXT_FAILED = 5
+PA_CONTEXT_TERMINATED = 6
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
+
+
+# --- libpulse (ctypes) ---
+
+class PaSampleSpec(Structure):
+    _fields_ = [("format", c_int), ("rate", c_uint32), ("channels", c_uint8)]
+
+
+class PaChannelMap(Structure):
+    _fields_ = [("channels", c_uint8), ("map", c_int * 32)]
+
+
+class PaCVolume(Structure):
+    _fields_ = [("channels", c_uint8), ("values", c_uint32 * 32)]
+
+
+class PaDeviceInfo(Structure):
+    """Début commun de pa_sink_info et pa_source_info (seuls ces champs sont lus)"""
+    _fields_ = [("name", c_char_p), ("index", c_uint32), ("description", c_char_p),
+                ("sample_spec", PaSampleSpec), ("channel_map", PaChannelMap),
+                ("owner_module", c_uint32), ("volume", PaCVolume), ("mute", c_int)]
+
+
+STATE_CB = CFUNCTYPE(None, c_void_p, c_void_p)
+INFO_CB = CFUNCTYPE(None, c_void_p, POINTER(PaDeviceInfo), c_int, c_void_p)
+SUCCESS_CB = CFUNCTYPE(None, c_void_p, c_int, c_void_p)
+
+pa = ctypes.CDLL("libpulse.so.0")
+pa_glib = ctypes.CDLL("libpulse-mainloop-glib.so.0")
+pa_glib.pa_glib_mainloop_new.restype = c_void_p
+pa_glib.pa_glib_mainloop_new.argtypes = [c_void_p]
+pa_glib.pa_glib_mainloop_get_api.restype = c_void_p
+pa_glib.pa_glib_mainloop_get_api.argtypes = [c_void_p]
+pa.pa_context_new.restype = c_void_p
+pa.pa_context_new.argtypes = [c_void_p, c_char_p]
+pa.pa_context_connect.argtypes = [c_void_p, c_char_p, c_int, c_void_p]
+pa.pa_context_set_state_callback.argtypes = [c_void_p, STATE_CB, c_void_p]
+pa.pa_context_get_state.argtypes = [c_void_p]
+pa.pa_context_unref.argtypes = [c_void_p]
+pa.pa_operation_unref.argtypes = [c_void_p]
+for fn in ("pa_context_get_sink_info_by_name", "pa_context_get_source_info_by_name"):
+    getattr(pa, fn).restype = c_void_p
+    getattr(pa, fn).argtypes = [c_void_p, c_char_p, INFO_CB, c_void_p]
+for fn in ("pa_context_set_sink_volume_by_name", "pa_context_set_source_volume_by_name"):
+    getattr(pa, fn).restype = c_void_p
+    getattr(pa, fn).argtypes = [c_void_p, c_char_p, POINTER(PaCVolume), SUCCESS_CB, c_void_p]
+for fn in ("pa_context_set_sink_mute_by_name", "pa_context_set_source_mute_by_name"):
+    getattr(pa, fn).restype = c_void_p
+    getattr(pa, fn).argtypes = [c_void_p, c_char_p, c_int, SUCCESS_CB, c_void_p]
+
+
+class AudioDevice:
+    """Réglages en attente d'un périphérique (cumulés tant qu'un réglage est en cours)"""
+
+    def __init__(self, key, name, kind, title, icon):
+        self.key = key
+        self.name = name
+        self.get_info = getattr(pa, f"pa_context_get_{kind}_info_by_name")
+        self.set_volume = getattr(pa, f"pa_context_set_{kind}_volume_by_name")
+        self.set_mute = getattr(pa, f"pa_context_set_{kind}_mute_by_name")
+        self.title = title
+        self.icon = icon
+        self.delta = 0
+        self.toggle_mute = False
+        self.presses = 0        # Appuis pas encore pris en compte
+        self.first_press = 0
+        self.batch = (0, 0)     # (appuis, premier appui) du réglage en cours
+        self.busy = False
+        self.ops = 0
+        self.result = None      # (volume, muet, bascule) appliqués
+
+
+class MediaKeys:
+    def __init__(self):
+        self.session_bus = Gio.bus_get_sync(Gio.BusType.SESSION, None)
+        self.system_bus = Gio.bus_get_sync(Gio.BusType.SYSTEM, None)
+        self.notification_ids = {}
+
+        # Audio
+        self.devices = [
+            AudioDevice("output", b"@DEFAULT_SINK@", "sink", "Volume", "audio-volume"),
+            AudioDevice("input", b"@DEFAULT_SOURCE@", "source", "Microphone", "mic-volume"),
+        ]
+        # Les callbacks ctypes doivent rester référencés tant que libpulse peut les appeler
+        self.state_cb = STATE_CB(self.on_context_state)
+        self.info_cb = INFO_CB(self.on_device_info)
+        self.success_cb = SUCCESS_CB(self.on_device_set)
+        self.mainloop = pa_glib.pa_glib_mainloop_new(None)
+        self.context = None
+        self.connect_pulse()
+
+        # Luminosité
+        self.backlight = None
+        for name in sorted(os.listdir(BACKLIGHT_DIR)) if os.path.isdir(BACKLIGHT_DIR) else []:
+            self.backlight = name
+            with open(os.path.join(BACKLIGHT_DIR, name, "max_brightness")) as f:
+                self.brightness_max = int(f.read())
+            break
+        self.brightness_delta = 0
+        self.brightness_presses = 0
+        self.brightness_first_press = 0
+        self.brightness_batch = (0, 0)
+        self.brightness_busy = False
+
+        # FIFO de commandes
+        self.buffer = b""
+        if os.path.exists(FIFO_PATH) and not stat.S_ISFIFO(os.stat(FIFO_PATH).st_mode):
+            os.unlink(FIFO_PATH)  # Fichier normal créé par un echo pendant que le daemon était arrêté
+        if not os.path.exists(FIFO_PATH):
+            os.mkfifo(FIFO_PATH, 0o600)
+        # O_RDWR : le FIFO a toujours un écrivain, pas de fin de fichier entre deux appuis
+        self.fifo = os.open(FIFO_PATH, os.O_RDWR | os.O_NONBLOCK)
+        GLib.io_add_watch(self.fifo, GLib.PRIORITY_DEFAULT, GLib.IO_IN, self.on_fifo)
+
+    # --- Commandes ---
+
+    def on_fifo(self, fd, _condition):
+        while True:
+            try:
+                data = os.read(fd, 4096)
+            except BlockingIOError:
+                break
+            if not data:
+                break
+            self.buffer += data
+        *lines, self.buffer = self.buffer.split(b"\n")
+        now = time.monotonic()
+        for line in lines:
+            args = line.decode(errors="replace").split()
+            try:
+                self.handle(args, now)
+            except (ValueError, IndexError):
+                log(f"Commande invalide : {line!r}")
+        return GLib.SOURCE_CONTINUE
+
+    def handle(self, args, now):
+        command = args[0]
+        if command in ("volume", "mute"):
+            device = next((d for d in self.devices if d.key == args[1]), None)
+            if device is None:
+                raise ValueError(args[1])
+            if command == "volume":
+                device.delta += int(args[2])
+            else:
+                device.toggle_mute = not device.toggle_mute
+            if not device.presses:
+                device.first_press = now
+            device.presses += 1
+            if not device.busy:
+                self.apply_audio(device)
+        elif command == "brightness":
+            self.brightness_delta += int(args[1])
+            if not self.brightness_presses:
+                self.brightness_first_press = now
+            self.brightness_presses += 1
+            if not self.brightness_busy:
+                self.apply_brightness()
+        else:
+            raise ValueError(command)
+
+    # --- Audio ---
+
+    def connect_pulse(self):
+        if self.context:
+            pa.pa_context_unref(self.context)
+        api = pa_glib.pa_glib_mainloop_get_api(self.mainloop)
+        self.context = pa.pa_context_new(api, b"media_keys")
+        pa.pa_context_set_state_callback(self.context, self.state_cb, None)
+        pa.pa_context_connect(self.context, None, 0, None)
+
+    def on_context_state(self, context, _userdata):
+        state = pa.pa_context_get_state(context)
+        if state == PA_CONTEXT_READY:
+            log("Connecté à PulseAudio")
+            for device in self.devices:
+                if device.presses and not device.busy:
+                    self.apply_audio(device)
+        elif state in (PA_CONTEXT_FAILED, PA_CONTEXT_TERMINATED):
+            log("Connexion PulseAudio perdue, reconnexion...")
+            for device in self.devices:
+                device.busy = False
+            GLib.timeout_add_seconds(RECONNECT_DELAY, self.on_reconnect)
+
+    def on_reconnect(self):
+        self.connect_pulse()
+        return GLib.SOURCE_REMOVE
+
+    def apply_audio(self, device):
+        if pa.pa_context_get_state(self.context) != PA_CONTEXT_READY:
+            return  # Appliqué dès que le contexte est prêt
+        device.busy = True
+        op = device.get_info(self.context, device.name, self.info_cb, self.devices.index(device))
+        if op:
+            pa.pa_operation_unref(op)
+        else:
+            device.busy = False
+
+    def on_device_info(self, _context, info, eol, userdata):
+        device = self.devices[userdata or 0]
+        if eol < 0:
+            log(f"{device.title}: périphérique introuvable")
+            device.busy = False
+            device.delta, device.toggle_mute, device.presses = 0, False, 0
+            return
+        if eol or not info:
+            return
+
+        volume = info.contents.volume
+        current = round(max(volume.values[:volume.channels]) * 100 / PA_VOLUME_NORM)
+        muted = bool(info.contents.mute)
+        delta, toggle_mute = device.delta, device.toggle_mute
+        device.delta, device.toggle_mute = 0, False
+        device.batch = (device.presses, device.first_press)
+        device.presses = 0
+
+        level = max(0, min(VOLUME_MAX, current + delta))
+        device.ops = 0
+        if level != current:
+            cvolume = PaCVolume()
+            cvolume.channels = volume.channels
+            for i in range(volume.channels):
+                cvolume.values[i] = level * PA_VOLUME_NORM // 100
+            self.run_op(device, device.set_volume(self.context, device.name, ctypes.byref(cvolume),
+                                                  self.success_cb, userdata))
+        if toggle_mute:
+            muted = not muted
+            self.run_op(device, device.set_mute(self.context, device.name, int(muted), self.success_cb, userdata))
+        device.result = (level, muted, toggle_mute)
+        if not device.ops:
+            self.audio_done(device)
+
+    def run_op(self, device, op):
+        if op:
+            device.ops += 1
+            pa.pa_operation_unref(op)
+
+    def on_device_set(self, _context, _success, userdata):
+        device = self.devices[userdata or 0]
+        device.ops -= 1
+        if device.ops <= 0:
+            self.audio_done(device)
+
+    def audio_done(self, device):
+        level, muted, toggled = device.result
+        presses, first_press = device.batch
+        log(f"{device.title}: {level}%{' (muet)' if muted else ''}, {presses} appui(s) "
+            f"en {(time.monotonic() - first_press) * 1000:.1f} ms")
+        device.busy = False
+
+        if muted:
+            icon = f"{device.icon}-muted"
+        elif level < VOLUME_MAX * 33 // 100:
+            icon = f"{device.icon}-low"
+        elif level < VOLUME_MAX * 66 // 100:
+            icon = f"{device.icon}-medium"
+        else:
+            icon = f"{device.icon}-high"
+        if toggled:
+            self.notify(device.key, f"{device.title}: {'Muted' if muted else 'Unmuted'}", icon)
+        else:
+            self.notify(device.key, f"{device.title}: {level}%", icon, level)
+
+        # Appuis arrivés pendant le réglage : un seul réglage cumulé
+        if device.presses:
+            self.apply_audio(device)
+
+    # --- Luminosité ---
+
+    def read_brightness(self):
+        with open(os.path.join(BACKLIGHT_DIR, self.backlight, "brightness")) as f:
+            return int(f.read())
+
+    def apply_brightness(self):
+        if not self.backlight:
+            self.brightness_delta, self.brightness_presses = 0, 0
+            return
+        delta, self.brightness_delta = self.brightness_delta, 0
+        self.brightness_batch = (self.brightness_presses, self.brightness_first_press)
+        self.brightness_presses = 0
+        # Échelle perceptive de brightnessctl -e : pourcentage = (valeur / max) ^ (1 / e)
+        current = (self.read_brightness() / self.brightness_max) ** (1 / BRIGHTNESS_EXPONENT) * 100
+        percent = max(0.0, min(100.0, current + delta))
+        value = max(BRIGHTNESS_MIN, round(self.brightness_max * (percent / 100) ** BRIGHTNESS_EXPONENT))
+
+        self.brightness_busy = True
+        self.system_bus.call(
+            "org.freedesktop.login1", "/org/freedesktop/login1/session/auto", "org.freedesktop.login1.Session",
+            "SetBrightness", GLib.Variant("(ssu)", ("backlight", self.backlight, value)),
+            None, Gio.DBusCallFlags.NONE, -1, None, self.on_brightness_set, round(percent))
+
+    def on_brightness_set(self, bus, result, percent):
+        try:
+            bus.call_finish(result)
+        except GLib.Error as e:
+            log(f"Luminosité: SetBrightness a échoué ({e.message})")
+        presses, first_press = self.brightness_batch
+        log(f"Luminosité: {percent}%, {presses} appui(s) en {(time.monotonic() - first_press) * 1000:.1f} ms")
+        self.brightness_busy = False
+        self.notify("brightness", f"Brightness: {percent}%", "contrast", percent)
+
+        if self.brightness_presses:
+            self.apply_brightness()
+
+    # --- Notifications (D-Bus, équivalent de notify-send -r) ---
+
+    def notify(self, key, summary, icon, value=None):
+        hints = {"value": GLib.Variant("i", value)} if value is not None else {}
+        self.session_bus.call(
+            "org.freedesktop.Notifications", "/org/freedesktop/Notifications", "org.freedesktop.Notifications",
+            "Notify", GLib.Variant("(susssasa{sv}i)", ("media_keys", self.notification_ids.get(key, 0), icon,
+                                                       summary, "", [], hints, -1)),
+            GLib.VariantType("(u)"), Gio.DBusCallFlags.NONE, -1, None, self.on_notified, key)
+
+    def on_notified(self, bus, result, key):
+        try:
+            self.notification_ids[key] = bus.call_finish(result).unpack()[0]
+        except GLib.Error:
+            pass
+
+
+def main():
+    log("=== Démarrage daemon media_keys ===")
+    MediaKeys()
+    loop = GLib.MainLoop()
+    for sig in (2, 15):  # SIGINT, SIGTERM
+        GLib.unix_signal_add(GLib.PRIORITY_DEFAULT, sig, loop.quit)
+    loop.run()
+    os.unlink(FIFO_PATH)
+    log("=== Arrêt daemon media_keys ===")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""
+Orchestrateur de démarrage de session Hyprland
+Lance les services déclarés dans SERVICES en parallèle, chacun dès que ses dépendances
+sont prêtes, puis écrit une chronologie par service dans LOG_FILE.
+
+Un service est considéré prêt selon son critère "ready" (au lieu d'un sleep fixe) :
+- "spawn"            : dès le lancement (défaut)
+- "exit"             : quand la commande se termine (code 0, sinon échec)
+- "socket:<chemin>"  : quand le socket unix accepte une connexion
+- "layer:<espace>"   : quand Hyprland ouvre une surface layer-shell de ce namespace
+- "window:<classe>"  : quand Hyprland ouvre une fenêtre de cette classe
+
+Les événements layer/window sont lus sur le socket2 de Hyprland, la fin des process via
+pidfd. Un service qui échoue ou dépasse READY_TIMEOUT ne bloque pas ses dépendants :
+le bureau doit démarrer quoi qu'il arrive, l'incident est noté dans la chronologie.
+"""
+import os
+import selectors
+import shlex
+import socket
+import subprocess
+import time
+
+# Configuration
+LOG_FILE = "/tmp/session_startup.log"
+READY_TIMEOUT = 10.0      # Attente maximale de la disponibilité d'un service (secondes)
+SOCKET_POLL = 0.05        # Intervalle de test des sockets attendus (secondes)
+
+# Graphe de démarrage : dépendances dans "after"
+SERVICES = {
+    "hypr_events": {
+        # Broker socket2 partagé par wallpaper_manager et window_layout
+        "cmd": "python3 ~/.config/hypr/scripts/hypr_events.py daemon",
+        "ready": "socket:$XDG_RUNTIME_DIR/hypr_events.sock",
+    },
+    "wallpaper": {
+        "cmd": "python3 ~/.config/hypr/scripts/wallpaper_manager.py",
+        "after": ["hypr_events"],
+        "ready": "socket:/tmp/wallpaper_manager_mpv.sock",
+    },
+    "waybar": {
+        "cmd": "waybar",
+        # Les modules custom de waybar démarrent le helper de statut
+        "ready": "socket:$XDG_RUNTIME_DIR/waybar_status.sock",
+    },
+    "waybar_manager": {
+        "cmd": "python3 ~/.config/hypr/scripts/waybar_manager.py",
+        "after": ["waybar"],
+    },
+    "dock": {
+        "cmd": "nwg-dock-hyprland -d -hd 0 -i 48 -mb 10",
+    },
+    "clipboard": {
+        "cmd": "wl-paste -t text --watch python3 ~/.config/hypr/scripts/clipboard_history.py store",
+    },
+    "media_keys": {
+        "cmd": "python3 ~/.config/hypr/scripts/media_keys.py",
+    },
+    "hypridle": {
+        "cmd": "hypridle",
+    },
+    "plugins": {
+        "cmd": "hyprpm reload -n",
+        "ready": "exit",
+    },
+    "layout": {
+        "cmd": "~/.config/hypr/scripts/layout_toggle.sh init",
+        "after": ["plugins"],
+        "ready": "exit",
+    },
+    "terminals": {
+        "cmd": "sh ~/.config/hypr/startup_terminals.sh",
+        "after": ["layout", "hypr_events"],
+        "ready": "exit",
+    },
+}
+
+HYPR_DIR = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/run/user/%d" % os.getuid()), "hypr",
+                        os.environ.get("HYPRLAND_INSTANCE_SIGNATURE", ""))
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"[{time.strftime('%H:%M:%S')}] {msg}\n")
+
+
+def hyprland_age():
+    """Secondes écoulées depuis le lancement du process Hyprland (None si introuvable)"""
+    for pid in filter(str.isdigit, os.listdir("/proc")):
+        try:
+            with open(f"/proc/{pid}/comm") as f:
+                if f.read().strip() != "Hyprland":
+                    continue
+            with open(f"/proc/{pid}/stat") as f:
+                start_ticks = int(f.read().rsplit(")", 1)[1].split()[19])
+            with open("/proc/uptime") as f:
+                uptime = float(f.read().split()[0])
+            return uptime - start_ticks / os.sysconf("SC_CLK_TCK")
+        except (OSError, ValueError, IndexError):
+            pass
+    return None
+
+
+def socket_ready(path):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        try:
+            sock.connect(path)
+            return True
+        except OSError:
+            return False
+
+
+class Service:
+    def __init__(self, name, spec):
+        self.name = name
+        self.cmd = [os.path.expanduser(os.path.expandvars(arg)) for arg in shlex.split(spec["cmd"])]
+        self.after = spec.get("after", [])
+        kind, _, target = spec.get("ready", "spawn").partition(":")
+        self.ready_kind = kind
+        self.ready_target = os.path.expandvars(target)
+        self.process = None
+        self.pidfd = -1
+        self.started = None
+        self.finished = None
+        self.status = "en attente"
+
+    @property
+    def done(self):
+        return self.finished is not None
+
+
+class Orchestrator:
+    def __init__(self, services):
+        self.services = {name: Service(name, spec) for name, spec in services.items()}
+        self.selector = selectors.DefaultSelector()
+        self.events = None
+        self.buffer = b""
+        self.t0 = time.monotonic()
+
+        for service in self.services.values():
+            missing = [dep for dep in service.after if dep not in self.services]
+            if missing:
+                log(f"{service.name}: dépendance inconnue {', '.join(missing)} (ignorée)")
+                service.after = [dep for dep in service.after if dep in self.services]
+
+        # Abonnement au socket2 avant tout lancement pour ne rater aucun événement
+        if any(s.ready_kind in ("layer", "window") for s in self.services.values()):
+            try:
+                self.events = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+                self.events.connect(os.path.join(HYPR_DIR, ".socket2.sock"))
+                self.selector.register(self.events, selectors.EVENT_READ, "events")
+            except OSError as e:
+                log(f"Socket2 Hyprland indisponible ({e}) : critères layer/window ignorés")
+                self.events = None
+
+    def elapsed(self):
+        return time.monotonic() - self.t0
+
+    # --- Cycle de vie des services ---
+
+    def start(self, service):
+        service.started = self.elapsed()
+        service.status = "lancé"
+        try:
+            service.process = subprocess.Popen(service.cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL,
+                                               stderr=subprocess.DEVNULL, start_new_session=True)
+        except OSError as e:
+            self.finish(service, f"échec du lancement ({e.strerror})")
+            return
+
+        if service.ready_kind == "spawn":
+            self.finish(service, "prêt")
+            return
+        if service.ready_kind in ("layer", "window") and self.events is None:
+            self.finish(service, "lancé (sans suivi)")
+            return
+        try:
+            service.pidfd = os.pidfd_open(service.process.pid)
+            self.selector.register(service.pidfd, selectors.EVENT_READ, service)
+        except OSError:
+            pass  # Déjà terminé : détecté au prochain passage par poll()
+
+    def finish(self, service, status):
+        if service.done:
+            return
+        service.finished = self.elapsed()
+        service.status = status
+
+    def on_exit(self, service):
+        self.selector.unregister(service.pidfd)
+        os.close(service.pidfd)
+        service.pidfd = -1
+        code = service.process.wait()
+        if service.ready_kind == "exit":
+            self.finish(service, "terminé" if code == 0 else f"échec (code {code})")
+        else:
+            self.finish(service, f"arrêté avant d'être prêt (code {code})")
+
+    def on_hypr_events(self):
+        data = self.events.recv(4096)
+        if not data:
+            self.selector.unregister(self.events)
+            self.events.close()
+            self.events = None
+            return
+        self.buffer += data
+        *lines, self.buffer = self.buffer.split(b"\n")
+        for line in lines:
+            event, _, payload = line.decode(errors="replace").partition(">>")
+            if event == "openlayer":
+                self.match("layer", payload)
+            elif event == "openwindow":
+                fields = payload.split(",", 3)
+                if len(fields) >= 3:
+                    self.match("window", fields[2])
+
+    def match(self, kind, target):
+        for service in self.services.values():
+            if service.started is not None and service.ready_kind == kind and service.ready_target == target:
+                self.finish(service, "prêt")
+
+    def check_pending(self):
+        """Sockets attendus, process terminés sans pidfd et délais dépassés"""
+        now = self.elapsed()
+        for service in self.services.values():
+            if service.started is None or service.done:
+                continue
+            if service.ready_kind == "socket" and socket_ready(service.ready_target):
+                self.finish(service, "prêt")
+            elif service.pidfd < 0 and service.process and service.process.poll() is not None:
+                code = service.process.returncode
+                ok = service.ready_kind == "exit" and code == 0
+                self.finish(service, "terminé" if ok else f"échec (code {code})")
+            elif now - service.started > READY_TIMEOUT:
+                self.finish(service, f"délai dépassé ({READY_TIMEOUT:.0f} s)")
+
+    # --- Boucle principale ---
+
+    def run(self):
+        pending = dict(self.services)
+        while True:
+            for name, service in list(pending.items()):
+                if all(self.services[dep].done for dep in service.after):
+                    del pending[name]
+                    self.start(service)
+
+            if not pending and all(service.done for service in self.services.values()):
+                break
+
+            waiting_socket = any(s.started is not None and not s.done and s.ready_kind == "socket"
+                                 for s in self.services.values())
+            timeout = SOCKET_POLL if waiting_socket else 0.5
+            for key, _mask in self.selector.select(timeout):
+                if key.data == "events":
+                    self.on_hypr_events()
+                else:
+                    self.on_exit(key.data)
+            self.check_pending()
+
+        if self.events:
+            self.events.close()
+        self.report()
+
+    def report(self):
+        log("=== Chronologie du démarrage de session ===")
+        for service in sorted(self.services.values(), key=lambda s: (s.started, s.finished)):
+            ready = f"{service.ready_kind}:{service.ready_target}" if service.ready_target else service.ready_kind
+            log(f"  +{service.started:6.3f}s -> +{service.finished:6.3f}s  {service.name:<15} "
+                f"{service.status} [{ready}]")
+        total = self.elapsed()
+        age = hyprland_age()
+        since_login = f", {age:.2f} s depuis le lancement de Hyprland" if age is not None else ""
+        log(f"Session prête en {total:.2f} s{since_login}")
+
+
+def main():
+    Orchestrator(SERVICES).run()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,365 @@
+#!/usr/bin/env python3
+"""
+Gestionnaire de fond d'écran par workspace - Version contrôleur unique
+Comportement:
+- Workspace 1 : image statique (wall*.png)
+- Autres workspaces : vidéo animée (mpvpaper)
+- Rotation de la vidéo toutes les ROTATE_INTERVAL secondes
+
+Une seule instance mpvpaper reste lancée pour toute la session et est pilotée par l'IPC
+JSON de mpv : passer sur le workspace 1 met la vidéo en pause et affiche l'image statique
+en overlay, revenir sur un autre workspace retire l'overlay et reprend la lecture. Pas de
+relance de mpvpaper ni de décodeur à froid. La prochaine vidéo de la rotation est déjà
+dans la playlist (prefetch-playlist) et le changement se fait par playlist-next.
+
+Les changements de workspace arrivent par le broker d'événements partagé (hypr_events.py).
+Pendant le mode jeu, mpvpaper est gelé (gamemode_governor.py) : le contrôleur ne lui envoie
+rien tant que l'état du gouverneur est actif, et rattrape le workspace courant au premier
+événement qui suit.
+Dépendances: mpvpaper, swaybg, ffmpeg (conversion unique de l'image statique pour l'overlay)
+"""
+import json
+import os
+import random
+import selectors
+import signal
+import socket
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import hypr_events  # noqa: E402
+
+# --- Configuration ---
+STATIC_WALLPAPER_DIR = "/usr/share/hypr/"
+VIDEO_DIR = "/home/aurel/BACK_ALL/"
+LOG_FILE = "/home/aurel/wallpaper_manager.log"
+MONITOR = "eDP-1"
+ROTATE_INTERVAL = 600    # 10 minutes
+VIDEO_EXTENSIONS = (".mp4", ".gif", ".webm")
+MPV_OPTIONS = "no-audio loop --hwdec=auto --hwdec-codecs=all --fps=30 --prefetch-playlist=yes"
+STATIC_WORKSPACE = "1"
+
+# --- Fichiers temporaires et de verrouillage ---
+TOGGLE_FILE = "/tmp/hypr_automations_toggle"
+LOCK_FILE = "/tmp/wallpaper_manager.lock"
+MPV_SOCKET = "/tmp/wallpaper_manager_mpv.sock"
+OVERLAY_FILE = "/tmp/wallpaper_manager_static_{width}x{height}.bgra"
+CURRENT_WORKSPACE_FILE = "/tmp/hypr_current_workspace"
+GAMEMODE_STATE_FILE = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "gamemode_governor.json")
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"[{time.strftime('%H:%M:%S')}] {msg}\n")
+
+
+def find_files(directory, predicate):
+    found = []
+    for root, _dirs, files in os.walk(directory):
+        found += [os.path.join(root, name) for name in files if predicate(name)]
+    return found
+
+
+def pick_static_wallpaper():
+    """Sélectionne un fond d'écran statique UNIQUEMENT parmi les wall*.png"""
+    walls = find_files(STATIC_WALLPAPER_DIR, lambda name: name.startswith("wall") and name.endswith(".png"))
+    return random.choice(walls) if walls else "/usr/share/hypr/wall0.png"
+
+
+def pick_video(exclude=None):
+    videos = find_files(VIDEO_DIR, lambda name: name.endswith(VIDEO_EXTENSIONS))
+    others = [video for video in videos if video != exclude]
+    return random.choice(others or videos) if videos else None
+
+
+def connect_unix(path, timeout):
+    """Se connecte dès que le socket est prêt (remplace les sleep fixes)"""
+    deadline = time.monotonic() + timeout
+    while True:
+        try:
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            sock.connect(path)
+            return sock
+        except OSError:
+            sock.close()
+            if time.monotonic() >= deadline:
+                raise
+            time.sleep(0.05)
+
+
+class Mpv:
+    """Client JSON IPC de l'instance mpv embarquée par mpvpaper"""
+
+    def __init__(self, path, timeout=10):
+        self.sock = connect_unix(path, timeout=timeout)
+        self.sock.settimeout(5)
+        self.buffer = b""
+        self.request_id = 0
+        # Seules les réponses nous intéressent : pas d'événements qui s'accumulent dans le socket
+        self.command("disable_event", "all")
+
+    def command(self, *args):
+        self.request_id += 1
+        self.sock.sendall(json.dumps({"command": list(args), "request_id": self.request_id}).encode() + b"\n")
+        while True:
+            while b"\n" not in self.buffer:
+                chunk = self.sock.recv(4096)
+                if not chunk:
+                    raise ConnectionError("mpv a fermé le socket IPC")
+                self.buffer += chunk
+            line, self.buffer = self.buffer.split(b"\n", 1)
+            reply = json.loads(line)
+            if reply.get("request_id") != self.request_id:
+                continue
+            if reply.get("error") != "success":
+                raise RuntimeError(f"{args[0]}: {reply.get('error')}")
+            return reply.get("data")
+
+    def close(self):
+        self.sock.close()
+
+
+class WallpaperController:
+    def __init__(self):
+        self.static_wallpaper = pick_static_wallpaper()
+        self.current_video = pick_video()
+        self.next_video = None
+        self.workspace = None
+        self.process = None
+        self.mpv = None
+        self.overlay = None     # (chemin, largeur, hauteur) de l'image statique convertie
+        log(f"Fond d'écran statique pour cette session : {self.static_wallpaper}")
+
+    # --- Instance mpv ---
+
+    def ensure_mpv(self):
+        if self.mpv and self.process.poll() is None:
+            return
+        if self.process and self.process.poll() is None:
+            # IPC perdue mais mpvpaper toujours là : se reconnecter plutôt que d'en lancer un second
+            try:
+                self.mpv = Mpv(MPV_SOCKET, timeout=1)
+                log("IPC mpv reconnectée")
+                return
+            except (OSError, RuntimeError, ValueError) as e:
+                log(f"mpvpaper ne répond plus ({e}), arrêt avant relance")
+            self.process.terminate()
+            try:
+                self.process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self.process.kill()
+                self.process.wait()
+        elif self.process:
+            log(f"mpvpaper s'est arrêté (code {self.process.returncode}), relance")
+        if os.path.exists(MPV_SOCKET):
+            os.unlink(MPV_SOCKET)
+
+        start = time.monotonic()
+        self.process = subprocess.Popen(["mpvpaper", "-o", f"{MPV_OPTIONS} --input-ipc-server={MPV_SOCKET}",
+                                         MONITOR, self.current_video])
+        self.mpv = Mpv(MPV_SOCKET)
+        self.overlay = None
+        log(f"Action : mpvpaper lancé avec {self.current_video} ({(time.monotonic() - start) * 1000:.0f} ms)")
+        self.preload_next()
+
+    def drop_mpv(self):
+        """Ferme la connexion IPC après une erreur ; ensure_mpv se reconnecte ou relance"""
+        if self.mpv:
+            self.mpv.close()
+            self.mpv = None
+
+    def preload_next(self):
+        """Ajoute la prochaine vidéo à la playlist, mpv la précharge pendant la lecture"""
+        self.next_video = pick_video(exclude=self.current_video)
+        if self.next_video and self.next_video != self.current_video:
+            self.mpv.command("loadfile", self.next_video, "append")
+            log(f"Vidéo suivante préchargée : {self.next_video}")
+
+    def prepare_overlay(self):
+        """Convertit une seule fois l'image statique en BGRA brut à la taille de l'écran"""
+        if self.overlay:
+            return True
+        deadline = time.monotonic() + 3
+        while not (width := self.mpv.command("get_property", "osd-width")) and time.monotonic() < deadline:
+            time.sleep(0.05)
+        height = self.mpv.command("get_property", "osd-height")
+        if not width or not height:
+            log("Erreur : taille de l'écran inconnue, pas d'overlay")
+            return False
+
+        path = OVERLAY_FILE.format(width=width, height=height)
+        if not os.path.exists(path):
+            scale = f"scale={width}:{height}:force_original_aspect_ratio=increase,crop={width}:{height}"
+            result = subprocess.run(["ffmpeg", "-loglevel", "error", "-y", "-i", self.static_wallpaper,
+                                     "-vf", scale, "-f", "rawvideo", "-pix_fmt", "bgra", path],
+                                    capture_output=True)
+            if result.returncode != 0:
+                log(f"Erreur : conversion de l'image statique impossible : {result.stderr.decode().strip()}")
+                return False
+        self.overlay = (path, width, height)
+        return True
+
+    # --- Fonds d'écran ---
+
+    def show_static(self):
+        self.mpv.command("set_property", "pause", True)
+        if self.prepare_overlay():
+            path, width, height = self.overlay
+            self.mpv.command("overlay-add", 0, 0, 0, path, 0, "bgra", width, height, width * 4)
+
+    def show_video(self):
+        if self.overlay:
+            self.mpv.command("overlay-remove", 0)
+        self.mpv.command("set_property", "pause", False)
+
+    def set_wallpaper_for_workspace(self, workspace_id):
+        previous_ws = self.workspace
+        # Éviter les actions redondantes si on reste sur le même workspace
+        if workspace_id == previous_ws:
+            return
+        with open(CURRENT_WORKSPACE_FILE, "w") as f:
+            f.write(workspace_id)
+        if gamemode_active():
+            # Workspace non retenu : il sera appliqué au premier événement après le dégel
+            log(f"Mode jeu : workspace {workspace_id} ignoré (mpvpaper gelé)")
+            self.workspace = None
+            return
+        self.workspace = workspace_id
+
+        start = time.monotonic()
+        try:
+            self.ensure_mpv()
+            if workspace_id == STATIC_WORKSPACE:
+                self.show_static()
+            else:
+                self.show_video()
+        except (OSError, RuntimeError, ValueError) as e:
+            log(f"Erreur IPC mpv : {e}")
+            self.drop_mpv()
+            return
+        log(f"Changement : workspace {previous_ws} -> {workspace_id} "
+            f"({'image statique' if workspace_id == STATIC_WORKSPACE else 'vidéo'}, "
+            f"{(time.monotonic() - start) * 1000:.1f} ms)")
+
+    def rotate(self):
+        if not self.next_video or not self.mpv or gamemode_active():
+            return
+        start = time.monotonic()
+        try:
+            self.mpv.command("playlist-next", "force")
+            self.mpv.command("playlist-remove", 0)
+            self.current_video = self.next_video
+            self.preload_next()
+        except (OSError, RuntimeError, ValueError) as e:
+            log(f"Erreur IPC mpv pendant la rotation : {e}")
+            self.drop_mpv()
+            return
+        log(f"Rotation : {self.current_video} ({(time.monotonic() - start) * 1000:.1f} ms)")
+
+    def stop(self):
+        if self.process and self.process.poll() is None:
+            self.process.terminate()
+        for path in (LOCK_FILE, CURRENT_WORKSPACE_FILE, MPV_SOCKET):
+            if os.path.exists(path):
+                os.unlink(path)
+
+
+def gamemode_active():
+    """mpvpaper gelé par gamemode_governor.py : une commande IPC bloquerait jusqu'au timeout"""
+    try:
+        with open(GAMEMODE_STATE_FILE) as f:
+            return bool(json.load(f).get("active"))
+    except (OSError, ValueError):
+        return False
+
+
+def automations_enabled():
+    # Par défaut désactivé si fichier absent ou contient false
+    try:
+        with open(TOGGLE_FILE) as f:
+            return "false" not in f.read()
+    except OSError:
+        return False
+
+
+def acquire_lock():
+    """Prévention des instances multiples"""
+    try:
+        with open(LOCK_FILE) as f:
+            pid = int(f.read().strip())
+        os.kill(pid, 0)
+        log(f"Erreur : Le script est déjà en cours d'exécution (PID {pid}). Sortie.")
+        return False
+    except (OSError, ValueError):
+        pass
+    with open(LOCK_FILE, "w") as f:
+        f.write(str(os.getpid()))
+    return True
+
+
+def main():
+    if not automations_enabled():
+        log("Automatismes désactivés (Toggle OFF) - Utilisation du fond par défaut uniquement")
+        subprocess.Popen(["swaybg", "-i", pick_static_wallpaper(), "-m", "fill"], start_new_session=True)
+        return 0
+
+    if not acquire_lock():
+        return 1
+    with open(LOG_FILE, "w") as f:
+        f.write(f"--- Contrôleur démarré le {time.strftime('%c')} ---\n")
+
+    controller = WallpaperController()
+    if not controller.current_video:
+        log(f"Erreur : aucune vidéo dans {VIDEO_DIR}")
+        controller.stop()
+        return 1
+
+    # Nettoyage à la sortie
+    def on_exit(_signum, _frame):
+        controller.stop()
+        sys.exit(0)
+
+    signal.signal(signal.SIGINT, on_exit)
+    signal.signal(signal.SIGTERM, on_exit)
+
+    # Abonnement avant la lecture de l'état initial : aucun changement perdu entre les deux
+    events = hypr_events.Subscription(["workspacev2"], "wallpaper_manager")
+
+    # Appliquer le fond selon le workspace initial
+    initial_ws = str(hypr_events.query("workspace")["id"])
+    log(f"Workspace initial : {initial_ws}")
+    controller.set_wallpaper_for_workspace(initial_ws)
+
+    # Écouter les changements de workspace, la rotation sert de timeout
+    log("Écoute des événements...")
+    selector = selectors.DefaultSelector()
+    selector.register(events, selectors.EVENT_READ)
+    next_rotation = time.monotonic() + ROTATE_INTERVAL
+    while True:
+        if not selector.select(timeout=max(0, next_rotation - time.monotonic())):
+            controller.rotate()
+            next_rotation = time.monotonic() + ROTATE_INTERVAL
+            continue
+
+        records = events.read()
+        if records is None:
+            # Broker toujours là : abonné déconnecté (trop lent), on se réabonne et on resynchronise
+            events.close()
+            selector.unregister(events)
+            try:
+                events = hypr_events.Subscription(["workspacev2"], "wallpaper_manager", spawn=False)
+            except (ConnectionError, OSError):
+                log("Broker d'événements arrêté (fin de Hyprland), arrêt")
+                controller.stop()
+                return 0
+            log("Déconnecté par le broker, réabonné")
+            selector.register(events, selectors.EVENT_READ)
+            records = [{"name": str(hypr_events.query("workspace")["id"])}]
+        for record in records:
+            controller.set_wallpaper_for_workspace(record["name"])
+
+
+if __name__ == "__main__":
+    sys.exit(main())
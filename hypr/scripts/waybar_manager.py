@@ -1,135 +1,266 @@
 #!/usr/bin/env python3
 """
-Daemon d'auto-hide pour Waybar - Version corrigée
+Daemon d'auto-hide pour Waybar - Version événementielle
 Comportement:
 - Waybar cachée par défaut au démarrage
-- S'affiche quand la souris va en haut de l'écran
+- S'affiche quand la souris reste SHOW_DELAY en haut de l'écran
 - Reste visible tant que la souris est sur la barre
-- Se cache 2s après que la souris quitte la barre
+- Se cache HIDE_DELAY après que la souris quitte la barre
+- Super+B (waybar_toggle.sh) épingle/cache la barre manuellement
+
+Aucun polling quand la barre est cachée : une surface layer-shell transparente de
+TRIGGER_ZONE pixels en haut de chaque écran reçoit les événements enter/leave du
+compositeur. Sur la couche TOP, elle passe au-dessus des fenêtres : elle ne fait que
+quelques pixels pour ne pas voler les clics en haut de l'écran (onglets, barres de titre),
+le curseur l'atteint quand même en butant sur le bord. Quand la barre est visible, la
+surface ne capte plus rien (les clics vont à waybar) et la position de la souris est lue
+directement sur le socket IPC de Hyprland (pas de fork de hyprctl) jusqu'à ce que la
+barre soit cachée.
+
+Dépendances: python-gobject, gtk3, gtk-layer-shell
 """
-import time
-import subprocess
 import os
 import signal
+import socket
+import time
+
+import cairo
+import gi
+
+gi.require_version("Gtk", "3.0")
+gi.require_version("GtkLayerShell", "0.1")
+from gi.repository import Gdk, Gio, GLib, Gtk, GtkLayerShell
 
 # Configuration
-TRIGGER_ZONE = 15        # Zone pour déclencher l'apparition (pixels depuis le haut)
+TRIGGER_ZONE = 2         # Zone pour déclencher l'apparition (pixels depuis le haut, au-dessus des fenêtres)
 WAYBAR_HEIGHT = 40       # Hauteur de la waybar + marge
 SHOW_DELAY = 0.2         # Délai avant d'afficher
 HIDE_DELAY = 2.0         # Délai avant de cacher
-POLL_INTERVAL = 0.15     # Intervalle de vérification
+POLL_INTERVAL = 0.15     # Intervalle de vérification, seulement quand la barre est visible
 STATE_FILE = "/tmp/waybar_visible"
+LOG_FILE = "/tmp/waybar_debug.log"
+
+HYPR_SOCKET = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/run/user/%d" % os.getuid()), "hypr",
+                           os.environ.get("HYPRLAND_INSTANCE_SIGNATURE", ""), ".socket.sock")
 
-# État interne (source de vérité)
-is_visible = False
 
 def log(msg):
     """Log simple vers fichier"""
-    with open("/tmp/waybar_debug.log", "a") as f:
+    with open(LOG_FILE, "a") as f:
         f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
 
+
 def get_cursor_y():
-    """Récupère la position Y de la souris"""
+    """Récupère la position Y de la souris via le socket IPC (pas de process)"""
     try:
-        res = subprocess.check_output(["hyprctl", "cursorpos"], text=True, stderr=subprocess.DEVNULL).strip()
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+            sock.connect(HYPR_SOCKET)
+            sock.sendall(b"cursorpos")
+            res = sock.recv(64).decode()
         return int(res.split(',')[1].strip())
-    except:
+    except (OSError, ValueError, IndexError):
         return 500
 
+
 def send_signal_to_waybar():
-    """Envoie SIGUSR1 à waybar pour toggle"""
-    subprocess.run(["pkill", "-SIGUSR1", "waybar"], capture_output=True)
-
-def show_waybar():
-    """Affiche la waybar"""
-    global is_visible
-    if not is_visible:
-        log(">>> SHOW waybar")
-        send_signal_to_waybar()
-        is_visible = True
+    """Envoie SIGUSR1 à waybar pour toggle (équivalent de pkill, sans fork)"""
+    for pid in filter(str.isdigit, os.listdir("/proc")):
+        try:
+            with open(f"/proc/{pid}/comm") as f:
+                if f.read().strip() == "waybar":
+                    os.kill(int(pid), signal.SIGUSR1)
+        except OSError:
+            pass
+
+
+class WaybarAutohide:
+    def __init__(self):
+        self.is_visible = False     # État interne (source de vérité)
+        self.triggers = {}          # Gdk.Monitor -> fenêtre déclencheur
+        self.enter_time = 0         # Entrée dans la zone de déclenchement
+        self.leave_time = 0         # Sortie de la barre (0 = souris sur la barre)
+        self.show_timer = 0
+        self.poll_timer = 0
+
+        display = Gdk.Display.get_default()
+        for i in range(display.get_n_monitors()):
+            self.add_trigger(display.get_monitor(i))
+        display.connect("monitor-added", lambda _d, monitor: self.add_trigger(monitor))
+        display.connect("monitor-removed", lambda _d, monitor: self.remove_trigger(monitor))
+
+        # Suivre les toggles manuels de waybar_toggle.sh sans polling (inotify)
+        self.state_monitor = Gio.File.new_for_path(STATE_FILE).monitor_file(Gio.FileMonitorFlags.NONE, None)
+        self.state_monitor.connect("changed", self.on_state_file_changed)
+
+    # --- Surfaces de déclenchement ---
+
+    def add_trigger(self, monitor):
+        win = Gtk.Window()
+        GtkLayerShell.init_for_window(win)
+        GtkLayerShell.set_namespace(win, "waybar-trigger")
+        GtkLayerShell.set_monitor(win, monitor)
+        GtkLayerShell.set_layer(win, GtkLayerShell.Layer.TOP)
+        GtkLayerShell.set_exclusive_zone(win, -1)
+        GtkLayerShell.set_keyboard_mode(win, GtkLayerShell.KeyboardMode.NONE)
+        for edge in (GtkLayerShell.Edge.TOP, GtkLayerShell.Edge.LEFT, GtkLayerShell.Edge.RIGHT):
+            GtkLayerShell.set_anchor(win, edge, True)
+        win.set_size_request(-1, TRIGGER_ZONE)
+
+        # Surface entièrement transparente
+        win.set_app_paintable(True)
+        visual = win.get_screen().get_rgba_visual()
+        if visual:
+            win.set_visual(visual)
+        win.connect("draw", self.on_draw)
+
+        win.add_events(Gdk.EventMask.ENTER_NOTIFY_MASK | Gdk.EventMask.LEAVE_NOTIFY_MASK)
+        win.connect("enter-notify-event", self.on_enter)
+        win.connect("leave-notify-event", self.on_leave)
+        win.show_all()
+        self.set_trigger_input(win, not self.is_visible)
+        self.triggers[monitor] = win
+
+    def remove_trigger(self, monitor):
+        win = self.triggers.pop(monitor, None)
+        if win:
+            win.destroy()
+
+    def set_trigger_input(self, win, enabled):
+        """Barre visible: région d'entrée vide pour laisser les clics à waybar"""
+        win.input_shape_combine_region(None if enabled else cairo.Region())
+
+    def on_draw(self, _win, cr):
+        cr.set_source_rgba(0, 0, 0, 0)
+        cr.set_operator(cairo.OPERATOR_SOURCE)
+        cr.paint()
+        return False
+
+    # --- Apparition (événementiel) ---
+
+    def on_enter(self, _win, _event):
+        if self.is_visible or self.show_timer:
+            return False
+        self.enter_time = time.monotonic()
+        self.show_timer = GLib.timeout_add(int(SHOW_DELAY * 1000), self.on_show_timeout)
+        return False
+
+    def on_leave(self, _win, _event):
+        # Souris ailleurs avant SHOW_DELAY -> reset
+        if self.show_timer:
+            GLib.source_remove(self.show_timer)
+            self.show_timer = 0
+        return False
+
+    def on_show_timeout(self):
+        self.show_timer = 0
+        self.show_waybar()
+        return GLib.SOURCE_REMOVE
+
+    # --- Disparition (polling IPC uniquement pendant que la barre est visible) ---
+
+    def on_poll(self):
+        y = get_cursor_y()
+        now = time.monotonic()
+
+        if y <= WAYBAR_HEIGHT:
+            # Souris sur la barre -> reset le timer de disparition
+            self.leave_time = 0
+        elif self.leave_time == 0:
+            self.leave_time = now
+        elif (now - self.leave_time) >= HIDE_DELAY:
+            self.hide_waybar(now - self.leave_time)
+            return GLib.SOURCE_REMOVE
+        return GLib.SOURCE_CONTINUE
+
+    def start_polling(self):
+        self.leave_time = 0
+        if not self.poll_timer:
+            self.poll_timer = GLib.timeout_add(int(POLL_INTERVAL * 1000), self.on_poll)
+
+    def stop_polling(self):
+        if self.poll_timer:
+            GLib.source_remove(self.poll_timer)
+            self.poll_timer = 0
+
+    # --- Actions ---
+
+    def set_visible(self, visible):
+        self.is_visible = visible
+        for win in self.triggers.values():
+            self.set_trigger_input(win, not visible)
         with open(STATE_FILE, "w") as f:
-            f.write("1")
+            f.write("1" if visible else "0")
 
-def hide_waybar():
-    """Cache la waybar"""
-    global is_visible
-    if is_visible:
-        log(">>> HIDE waybar")
+    def show_waybar(self):
+        """Affiche la waybar"""
+        if self.is_visible:
+            return
+        start = time.monotonic()
         send_signal_to_waybar()
-        is_visible = False
-        with open(STATE_FILE, "w") as f:
-            f.write("0")
-
-def init():
-    """Initialise waybar en état caché"""
-    global is_visible
-    log("=== Démarrage daemon v2 ===")
-    
-    # Lire l'état actuel depuis le fichier (pour gérer les restarts)
-    if os.path.exists(STATE_FILE):
-        with open(STATE_FILE, "r") as f:
-            is_visible = f.read().strip() == "1"
-    
-    # Si visible, on la cache
-    if is_visible:
-        log("Waybar visible au démarrage, on la cache")
+        self.set_visible(True)
+        self.start_polling()
+        done = time.monotonic()
+        log(f">>> SHOW waybar (latence: {(done - self.enter_time) * 1000:.0f} ms depuis l'entrée en zone, "
+            f"dont {(start - self.enter_time - SHOW_DELAY) * 1000:.1f} ms de retard timer "
+            f"et {(done - start) * 1000:.1f} ms de signal)")
+
+    def hide_waybar(self, waited):
+        """Cache la waybar"""
+        if not self.is_visible:
+            return
+        start = time.monotonic()
         send_signal_to_waybar()
-        is_visible = False
-    
-    with open(STATE_FILE, "w") as f:
-        f.write("0")
-    
-    log("Init complete, waybar cachée")
+        self.set_visible(False)
+        self.poll_timer = 0
+        log(f">>> HIDE waybar (latence: {waited * 1000:.0f} ms après la sortie de la barre, "
+            f"{(time.monotonic() - start) * 1000:.1f} ms de signal)")
 
-# Variables de timing
-hover_start = 0
-leave_start = 0
+    def on_state_file_changed(self, _monitor, _file, _other, event):
+        if event != Gio.FileMonitorEvent.CHANGES_DONE_HINT:
+            return
+        try:
+            with open(STATE_FILE) as f:
+                visible = f.read().strip() == "1"
+        except OSError:
+            return
+        if visible == self.is_visible:
+            return  # Notre propre écriture
 
-# Lancement
-init()
+        # Toggle manuel (Super+B): la barre reste affichée jusqu'au prochain toggle
+        log(f"Toggle manuel: {'visible (épinglée)' if visible else 'cachée'}")
+        self.is_visible = visible
+        for win in self.triggers.values():
+            self.set_trigger_input(win, not visible)
+        self.stop_polling()
 
-while True:
-    try:
-        y = get_cursor_y()
-        now = time.time()
-        
-        # Zones
-        in_trigger = y <= TRIGGER_ZONE
-        on_bar = y <= WAYBAR_HEIGHT
-        
-        if is_visible:
-            # === BARRE VISIBLE ===
-            if on_bar:
-                # Souris sur la barre -> reset le timer de disparition
-                leave_start = 0
-            else:
-                # Souris a quitté la barre
-                if leave_start == 0:
-                    leave_start = now
-                    log(f"Souris quitte barre (y={y}), timer 2s")
-                elif (now - leave_start) >= HIDE_DELAY:
-                    hide_waybar()
-                    leave_start = 0
-                    hover_start = 0
-        else:
-            # === BARRE CACHÉE ===
-            if in_trigger:
-                # Souris en zone haute
-                if hover_start == 0:
-                    hover_start = now
-                elif (now - hover_start) >= SHOW_DELAY:
-                    show_waybar()
-                    hover_start = 0
-                    leave_start = 0
-            else:
-                # Souris ailleurs -> reset
-                hover_start = 0
-        
-        time.sleep(POLL_INTERVAL)
-        
-    except KeyboardInterrupt:
-        log("=== Arrêt daemon ===")
-        break
-    except Exception as e:
-        log(f"Erreur: {e}")
-        time.sleep(1)
+    def init(self):
+        """Initialise waybar en état caché"""
+        log("=== Démarrage daemon v3 (événementiel) ===")
+
+        # Lire l'état actuel depuis le fichier (pour gérer les restarts)
+        visible = False
+        if os.path.exists(STATE_FILE):
+            with open(STATE_FILE, "r") as f:
+                visible = f.read().strip() == "1"
+
+        # Si visible, on la cache
+        if visible:
+            log("Waybar visible au démarrage, on la cache")
+            send_signal_to_waybar()
+        self.set_visible(False)
+        log("Init complete, waybar cachée")
+
+
+def main():
+    daemon = WaybarAutohide()
+    daemon.init()
+
+    loop = GLib.MainLoop()
+    for sig in (signal.SIGINT, signal.SIGTERM):
+        GLib.unix_signal_add(GLib.PRIORITY_DEFAULT, sig, loop.quit)
+    loop.run()
+    log("=== Arrêt daemon ===")
+
+
+if __name__ == "__main__":
+    main()
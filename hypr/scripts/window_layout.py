@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Lanceur de disposition de fenêtres déclarative
+Usage: window_layout.py <disposition.json>
+
+Toutes les commandes sont lancées en même temps. Chaque fenêtre est reconnue à son
+ouverture (événement openwindow du broker hypr_events.py, qui fournit aussi son PID) par le
+PID de sa commande, ou à défaut par sa classe, puis rangée dans un workspace spécial le temps que les autres arrivent. Une fois
+toutes les fenêtres là (ou après MAP_TIMEOUT), elles sont placées dans l'ordre déclaré :
+focus sur la fenêtre de référence, preselect de la direction, puis déplacement dans le
+workspace cible. L'ordre d'apparition n'a donc plus d'importance et aucun sleep n'est
+nécessaire.
+
+Format de la disposition :
+{
+  "workspace": "1",
+  "focus": 0,                          # index de la fenêtre à focus à la fin (optionnel)
+  "windows": [
+    {"cmd": "kitty", "class": "kitty"},
+    {"cmd": "kitty -e gemini", "class": "kitty", "split": "r", "relative_to": 0}
+  ]
+}
+"split" (l/r/u/d) s'applique par rapport à "relative_to" (défaut : fenêtre précédente).
+"""
+import json
+import os
+import selectors
+import shlex
+import socket
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import hypr_events  # noqa: E402
+
+# Configuration
+LOG_FILE = "/tmp/window_layout.log"
+MAP_TIMEOUT = 15.0               # Attente maximale de l'ouverture des fenêtres (secondes)
+STAGING_WORKSPACE = "special:window_layout"
+
+HYPR_DIR = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/run/user/%d" % os.getuid()), "hypr",
+                        os.environ.get("HYPRLAND_INSTANCE_SIGNATURE", ""))
+
+
+def log(msg):
+    line = f"[{time.strftime('%H:%M:%S')}] {msg}"
+    print(line)
+    with open(LOG_FILE, "a") as f:
+        f.write(line + "\n")
+
+
+def hypr_request(command):
+    """Requête sur le socket IPC de Hyprland (équivalent de hyprctl, sans fork)"""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(os.path.join(HYPR_DIR, ".socket.sock"))
+        sock.sendall(command.encode())
+        data = b""
+        while chunk := sock.recv(4096):
+            data += chunk
+    return data.decode()
+
+
+def hypr_batch(*dispatches):
+    return hypr_request("[[BATCH]]" + ";".join(f"dispatch {d}" for d in dispatches))
+
+
+class Window:
+    def __init__(self, index, spec):
+        self.index = index
+        self.cmd = [os.path.expanduser(arg) for arg in shlex.split(spec["cmd"])]
+        self.window_class = spec.get("class")
+        self.split = spec.get("split")
+        self.relative_to = spec.get("relative_to", index - 1)
+        self.process = None
+        self.address = None
+        self.mapped_at = None
+
+
+class Layout:
+    def __init__(self, spec):
+        self.workspace = str(spec.get("workspace", "1"))
+        self.focus = spec.get("focus")
+        self.windows = [Window(i, w) for i, w in enumerate(spec["windows"])]
+        self.t0 = time.monotonic()
+
+    def elapsed(self):
+        return time.monotonic() - self.t0
+
+    def launch(self):
+        for window in self.windows:
+            try:
+                window.process = subprocess.Popen(window.cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL,
+                                                  stderr=subprocess.DEVNULL, start_new_session=True)
+            except OSError as e:
+                log(f"Fenêtre {window.index}: lancement impossible ({e.strerror})")
+
+    def claim(self, pid, window_class):
+        """Associe une fenêtre ouverte à une entrée : PID de la commande, sinon classe"""
+        pending = [w for w in self.windows if w.address is None and w.process]
+        for window in pending:
+            if window.process.pid == pid:
+                return window
+        for window in pending:
+            if window.window_class and window.window_class == window_class:
+                return window
+        return None
+
+    def wait_windows(self):
+        events = hypr_events.Subscription(["openwindow"], "window_layout")
+        self.launch()
+
+        selector = selectors.DefaultSelector()
+        selector.register(events, selectors.EVENT_READ)
+        deadline = self.t0 + MAP_TIMEOUT
+        while any(w.address is None and w.process for w in self.windows):
+            timeout = deadline - time.monotonic()
+            if timeout <= 0 or not selector.select(timeout):
+                break
+            records = events.read()
+            if records is None:
+                break
+            for record in records:
+                window = self.claim(record["pid"], record["class"])
+                if window is None:
+                    continue
+                address = record["address"]
+                window.address = address
+                window.mapped_at = self.elapsed()
+                # Mise de côté en attendant les autres fenêtres
+                hypr_batch(f"movetoworkspacesilent {STAGING_WORKSPACE},address:{address}")
+        events.close()
+
+    def place(self):
+        placed = {}
+        for window in self.windows:
+            if window.address is None:
+                log(f"Fenêtre {window.index} ({' '.join(window.cmd)}) non ouverte après {MAP_TIMEOUT:.0f} s")
+                continue
+            dispatches = []
+            reference = placed.get(window.relative_to)
+            if reference and window.split:
+                dispatches += [f"focuswindow address:{reference.address}", f"layoutmsg preselect {window.split}"]
+            dispatches.append(f"movetoworkspace {self.workspace},address:{window.address}")
+            hypr_batch(*dispatches)
+            placed[window.index] = window
+
+        focus = placed.get(self.focus)
+        if focus:
+            hypr_batch(f"focuswindow address:{focus.address}")
+        return len(placed)
+
+    def run(self):
+        self.wait_windows()
+        mapped = self.elapsed()
+        count = self.place()
+        for window in self.windows:
+            if window.mapped_at is not None:
+                log(f"  fenêtre {window.index} ouverte à +{window.mapped_at:.3f}s ({' '.join(window.cmd)})")
+        log(f"Disposition terminée : {count}/{len(self.windows)} fenêtres en {self.elapsed():.3f} s "
+            f"(ouverture {mapped:.3f} s, placement {(self.elapsed() - mapped) * 1000:.0f} ms)")
+        return 0 if count == len(self.windows) else 1
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        return 1
+    with open(os.path.expanduser(sys.argv[1])) as f:
+        spec = json.load(f)
+    return Layout(spec).run()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,8 +1,8 @@
 #!/bin/sh
 
 # This script is designed to be run by Hyprland on startup.
-# It launches three kitty terminals in a specific order with delays
-# to ensure they are tiled correctly.
+# It launches three kitty terminals at once; window_layout.py places them
+# (left, top-right fastfetch, bottom-right gemini) as their windows open.
 
 TOGGLE_FILE="/tmp/hypr_automations_toggle"
 
@@ -13,14 +13,4 @@ if [ ! -f "$TOGGLE_FILE" ] || grep -q "false" "$TOGGLE_FILE"; then
     echo "Automatismes désactivés - Pas de lancement des terminaux"
     exit 0
 fi
-kitty &
-sleep 1
-
-# 2. Launch the top-right terminal (fastfetch).
-# This will split the screen, placing this terminal on the right.
-kitty -e zsh -c "fastfetch; zsh" &
-sleep 1
-
-# 3. Launch the bottom-right terminal (gemini).
-# This will split the right-hand container, placing this terminal below fastfetch.
-kitty -e gemini &
+exec python3 ~/.config/hypr/scripts/window_layout.py ~/.config/hypr/layouts/startup_terminals.json
@@ -14,7 +14,7 @@ echo "Dossier source: $REPO_DIR"
 # 1. INSTALLATION DES PAQUETS
 echo -e "\n${BLUE}[1/4] Installation des paquets nécessaires...${NC}"
 # Liste des paquets de base détectés dans ta config
-PACKAGES="hyprland waybar rofi wofi kitty dunst hyprlock hypridle waypaper swww zsh neofetch starship"
+PACKAGES="hyprland waybar rofi wofi kitty dunst hyprlock hypridle waypaper swww zsh neofetch starship python-gobject gtk-layer-shell"
 # Ajoute ici d'autres paquets si nécessaire
 
 if command -v pacman &> /dev/null; then
@@ -68,6 +68,7 @@ if [[ "$response" =~ ^([oO][uU][iI]|[oO])+$ ]]; then
     # SDDM
     if [ -d "$REPO_DIR/sddm/themes" ]; then
         echo "Installation thème SDDM..."
+        bash "$REPO_DIR/scripts/build_sddm_backgrounds.sh"
         sudo cp -r "$REPO_DIR/sddm/themes/"* /usr/share/sddm/themes/
         echo "Activez le thème dans /etc/sddm.conf"
     fi
@@ -0,0 +1,337 @@
+/*
+ * Host CPU microbenchmark for the elanmoc2 driver helpers
+ *
+ * The helpers are static, so the driver source is included as is and exercised
+ * without a sensor: no USB transfer, no state machine, only the parsing and
+ * command-building code with each device profile of the ID table.
+ *
+ * Output: one JSON object per line on stdout (ns/op, allocations/op), so runs
+ * from two commits can be diffed or compared with --baseline. A summary goes
+ * to stderr.
+ *
+ * Usage: elanmoc2-bench [--baseline previous.jsonl] [--filter substring]
+ */
+
+#include "elanmoc2.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_CALIBRATE_NS (20 * 1000 * 1000)
+#define BENCH_TARGET_NS (100 * 1000 * 1000)
+#define BENCH_RUNS 5
+#define BENCH_GALLERY_SIZE ELANMOC2_MAX_PRINTS
+#define BENCH_USER_ID "FP1-20261019-7-0A1B2C3D-bench"
+
+/* Allocation counter: GLib allocates through the C library, these wrappers see every call */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static guint64 bench_allocs;
+
+void *
+malloc (size_t size)
+{
+  __atomic_fetch_add (&bench_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n, size_t size)
+{
+  __atomic_fetch_add (&bench_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_calloc (n, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  if (ptr == NULL)
+    __atomic_fetch_add (&bench_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_realloc (ptr, size);
+}
+
+/* Fixtures shared by the cases of one profile */
+struct bench_fixture
+{
+  FpiDeviceElanMoC2 *self;
+  guint8             finger_info[64];
+  FpPrint           *print;
+  FpPrint           *gallery[BENCH_GALLERY_SIZE];
+};
+
+struct bench_case
+{
+  const char *name;
+  void        (*run) (struct bench_fixture *fx, guint64 iterations);
+};
+
+static volatile guint64 bench_sink;
+
+static void
+bench_prepare_cmd_identify (struct bench_fixture *fx, guint64 iterations)
+{
+  for (guint64 i = 0; i < iterations; i++)
+    {
+      g_autofree uint8_t *buffer = elanmoc2_prepare_cmd (fx->self, &cmd_identify);
+      bench_sink += buffer[1];
+    }
+}
+
+static void
+bench_prepare_cmd_commit (struct bench_fixture *fx, guint64 iterations)
+{
+  for (guint64 i = 0; i < iterations; i++)
+    {
+      g_autofree uint8_t *buffer = elanmoc2_prepare_cmd (fx->self, &cmd_commit);
+      bench_sink += buffer[1];
+    }
+}
+
+static void
+bench_classify_response (struct bench_fixture *fx, guint64 iterations)
+{
+  // Every code the sensor is known to send: progress codes and each table entry
+  static const unsigned char codes[] = {
+    0x00, 0x01, 0x03, 0x07,
+    ELANMOC2_RESP_MOVE_DOWN, ELANMOC2_RESP_MOVE_RIGHT, ELANMOC2_RESP_MOVE_UP, ELANMOC2_RESP_MOVE_LEFT,
+    ELANMOC2_RESP_MAX_ENROLLED_REACHED, ELANMOC2_RESP_SENSOR_DIRTY, ELANMOC2_RESP_NOT_ENROLLED,
+    ELANMOC2_RESP_NOT_ENOUGH_SURFACE, ELANMOC2_RESP_PLACE_FINGER,
+  };
+
+  for (guint64 i = 0; i < iterations; i++)
+    bench_sink += elanmoc2_classify_response (codes[i % G_N_ELEMENTS (codes)], ELANMOC2_RESP_KIND_TOUCH)->action;
+}
+
+static void
+bench_finger_info_is_present (struct bench_fixture *fx, guint64 iterations)
+{
+  for (guint64 i = 0; i < iterations; i++)
+    bench_sink += elanmoc2_finger_info_is_present (fx->self, fx->finger_info);
+}
+
+static void
+bench_print_new_from_finger_info (struct bench_fixture *fx, guint64 iterations)
+{
+  for (guint64 i = 0; i < iterations; i++)
+    {
+      FpPrint *print = elanmoc2_print_new_from_finger_info (fx->self, i % ELANMOC2_MAX_PRINTS, fx->finger_info);
+
+      g_object_unref (g_object_ref_sink (print));
+    }
+}
+
+static void
+bench_print_set_get_data (struct bench_fixture *fx, guint64 iterations)
+{
+  for (guint64 i = 0; i < iterations; i++)
+    {
+      g_autofree const guchar *user_id = NULL;
+      guchar finger_id, user_id_len;
+
+      elanmoc2_print_set_data (fx->print, i % ELANMOC2_MAX_PRINTS, strlen (BENCH_USER_ID),
+                               (const guchar *) BENCH_USER_ID);
+      elanmoc2_print_get_data (fx->print, &finger_id, &user_id_len, &user_id);
+      bench_sink += finger_id + user_id_len;
+    }
+}
+
+/**
+ * The matching loop of elanmoc2_identify_verify_report(), worst case: the identified print is the last one of a
+ * full gallery. The report function itself needs a running identify action, which this benchmark doesn't have.
+ */
+static void
+bench_gallery_scan (struct bench_fixture *fx, guint64 iterations)
+{
+  FpPrint *identified = fx->gallery[BENCH_GALLERY_SIZE - 1];
+
+  for (guint64 i = 0; i < iterations; i++)
+    for (int j = 0; j < BENCH_GALLERY_SIZE; j++)
+      if (fp_print_equal (fx->gallery[j], identified))
+        {
+          bench_sink += j;
+          break;
+        }
+}
+
+static const struct bench_case bench_cases[] = {
+  {"prepare_cmd/identify", bench_prepare_cmd_identify},
+  {"prepare_cmd/commit", bench_prepare_cmd_commit},
+  {"classify_response", bench_classify_response},
+  {"finger_info_is_present", bench_finger_info_is_present},
+  {"print_new_from_finger_info", bench_print_new_from_finger_info},
+  {"print_set_get_data", bench_print_set_get_data},
+  {"gallery_scan", bench_gallery_scan},
+};
+
+static gint64
+bench_now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int
+bench_compare_double (const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return (x > y) - (x < y);
+}
+
+/**
+ * Runs a case long enough for a stable figure: iterations are calibrated to BENCH_TARGET_NS, then the median of
+ * BENCH_RUNS runs is kept. Allocations are counted over all runs.
+ */
+static void
+bench_measure (const struct bench_case *bc, struct bench_fixture *fx, double *ns_per_op, double *allocs_per_op,
+               guint64 *iterations_out)
+{
+  guint64 iterations = 16;
+  gint64 elapsed;
+  double runs[BENCH_RUNS];
+  guint64 allocs;
+
+  // Warm up and calibrate
+  for (;;)
+    {
+      gint64 start = bench_now_ns ();
+      bc->run (fx, iterations);
+      elapsed = bench_now_ns () - start;
+      if (elapsed >= BENCH_CALIBRATE_NS)
+        break;
+      iterations *= 2;
+    }
+  iterations = MAX (1, iterations * BENCH_TARGET_NS / MAX (elapsed, 1));
+
+  allocs = __atomic_load_n (&bench_allocs, __ATOMIC_RELAXED);
+  for (int r = 0; r < BENCH_RUNS; r++)
+    {
+      gint64 start = bench_now_ns ();
+      bc->run (fx, iterations);
+      runs[r] = (double) (bench_now_ns () - start) / iterations;
+    }
+  allocs = __atomic_load_n (&bench_allocs, __ATOMIC_RELAXED) - allocs;
+
+  qsort (runs, BENCH_RUNS, sizeof (double), bench_compare_double);
+  *ns_per_op = runs[BENCH_RUNS / 2];
+  *allocs_per_op = (double) allocs / (iterations * BENCH_RUNS);
+  *iterations_out = iterations;
+}
+
+static void
+bench_fixture_init (struct bench_fixture *fx, unsigned short dev_type)
+{
+  guint offset;
+
+  fx->self = g_object_new (fpi_device_elanmoc2_get_type (), NULL);
+  fx->self->dev_type = dev_type;
+
+  // A finger info response as the sensor sends it, with a user ID written by libfprint
+  offset = dev_type == ELANMOC2_DEV_0C5E ? 3 : 2;
+  memset (fx->finger_info, 0, sizeof (fx->finger_info));
+  fx->finger_info[0] = 0x40;
+  memcpy (&fx->finger_info[offset], BENCH_USER_ID, strlen (BENCH_USER_ID));
+
+  fx->print = g_object_ref_sink (elanmoc2_print_new_with_user_id (fx->self, 0, strlen (BENCH_USER_ID),
+                                                                    (const guchar *) BENCH_USER_ID));
+  for (int i = 0; i < BENCH_GALLERY_SIZE; i++)
+    fx->gallery[i] = g_object_ref_sink (elanmoc2_print_new_from_finger_info (fx->self, i, fx->finger_info));
+}
+
+static void
+bench_fixture_clear (struct bench_fixture *fx)
+{
+  for (int i = 0; i < BENCH_GALLERY_SIZE; i++)
+    g_clear_object (&fx->gallery[i]);
+  g_clear_object (&fx->print);
+  g_clear_object (&fx->self);
+}
+
+/* Previous results, keyed by "bench profile" */
+static GHashTable *
+bench_load_baseline (const char *path)
+{
+  GHashTable *baseline = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  g_autofree gchar *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    {
+      g_printerr ("Cannot read baseline %s\n", path);
+      return baseline;
+    }
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (gchar **line = lines; *line; line++)
+    {
+      char name[64], profile[16];
+      double ns;
+
+      if (sscanf (*line, "{\"bench\":\"%63[^\"]\",\"profile\":\"%15[^\"]\",\"ns_per_op\":%lf", name, profile, &ns) == 3)
+        g_hash_table_insert (baseline, g_strdup_printf ("%s %s", name, profile), g_memdup2 (&ns, sizeof (ns)));
+    }
+  return baseline;
+}
+
+int
+main (int argc, char **argv)
+{
+  g_autoptr(GHashTable) baseline = NULL;
+  const char *filter = NULL;
+
+  for (int i = 1; i < argc; i++)
+    {
+      if (g_str_equal (argv[i], "--baseline") && i + 1 < argc)
+        baseline = bench_load_baseline (argv[++i]);
+      else if (g_str_equal (argv[i], "--filter") && i + 1 < argc)
+        filter = argv[++i];
+      else
+        {
+          g_printerr ("Usage: %s [--baseline previous.jsonl] [--filter substring]\n", argv[0]);
+          return 1;
+        }
+    }
+
+  g_printerr ("%-28s %-6s %12s %10s %10s\n", "bench", "dev", "ns/op", "allocs/op", "baseline");
+
+  // One profile per supported product ID of the driver's table
+  for (const FpIdEntry *entry = elanmoc2_id_table_custom; entry->pid != 0; entry++)
+    {
+      struct bench_fixture fx;
+      g_autofree gchar *profile = g_strdup_printf ("%04x", entry->pid);
+
+      bench_fixture_init (&fx, entry->driver_data);
+      for (gsize c = 0; c < G_N_ELEMENTS (bench_cases); c++)
+        {
+          const struct bench_case *bc = &bench_cases[c];
+          double ns_per_op, allocs_per_op;
+          guint64 iterations;
+          g_autofree gchar *delta = NULL;
+
+          if (filter && !strstr (bc->name, filter))
+            continue;
+
+          bench_measure (bc, &fx, &ns_per_op, &allocs_per_op, &iterations);
+          printf ("{\"bench\":\"%s\",\"profile\":\"%s\",\"ns_per_op\":%.2f,\"allocs_per_op\":%.2f,"
+                  "\"iterations\":%" G_GUINT64_FORMAT "}\n",
+                  bc->name, profile, ns_per_op, allocs_per_op, iterations);
+
+          if (baseline)
+            {
+              g_autofree gchar *key = g_strdup_printf ("%s %s", bc->name, profile);
+              const double *previous = g_hash_table_lookup (baseline, key);
+              delta = previous ? g_strdup_printf ("%+.1f%%", (ns_per_op / *previous - 1) * 100) : g_strdup ("new");
+            }
+          g_printerr ("%-28s %-6s %12.2f %10.2f %10s\n", bc->name, profile, ns_per_op, allocs_per_op,
+                      delta ? delta : "");
+        }
+      bench_fixture_clear (&fx);
+    }
+
+  fflush (stdout);
+  return 0;
+}
@@ -24,6 +24,15 @@
 
 #define FP_COMPONENT "elanmoc2"
 
+// Stdlib includes
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <linux/usbdevice_fs.h>
+
 // Library includes
 #include <glib.h>
 #include <sys/param.h>
@@ -44,25 +53,99 @@ struct _FpiDeviceElanMoC2
   unsigned char *buffer_in;
   gssize         buffer_in_len;
 
+  /* Quick command channel (EP 0x83), usable while a finger-wait command is pending on EP 0x84 */
+  unsigned char *quick_buffer_in;
+  gssize         quick_buffer_in_len;
+  GQueue         quick_queue;  // Queries waiting for the channel, sent one at a time
+  gboolean       quick_busy;   // A query is in flight (or the queue is being dispatched)
+  guint          op_serial;    // Bumped when an operation ends, so late quick responses can be dropped
+  gint           fw_version;   // -1 until read over the quick channel
+
+  /* Finger wait on EP 0x84: cancelled by elanmoc2_cancel(), or by the driver when the sensor ignores cmd_abort */
+  GCancellable *wait_cancellable;
+  guint         identify_abort_source;
+
   /* Command status data */
-  FpiSsm       *ssm;
-  unsigned char enrolled_num;
-  unsigned char print_index;
-  GPtrArray    *list_result;
+  FpiSsm                           *ssm;
+  gint                              recv_jump_state;
+  unsigned char                     enrolled_num;
+  unsigned char                     print_index;
+  GPtrArray                        *list_result;
+  gboolean                          identify_armed;
+  gboolean                          identify_empty;  // Enrolled count came back 0, finger wait aborted
 
   // Enroll
   gint     enroll_stage;
   FpPrint *enroll_print;
+  gint64   enroll_submit_time;
+  gboolean enroll_await_lift;
+  gint64   enroll_lift_retry_time;  // Last "remove finger" retry reported for an unlifted touch
+
+  /* Health statistics */
+  enum elanmoc2_stats_op stats_op;
+
+  /* Verified-presence cache */
+  FpPrint         *verify_cache_print;  // Enrolled print matched by the last identify/verify
+  gint64           verify_cache_time;   // Touch that produced the match
+  gint64           verify_cache_ttl_ms; // 0 when the cache is disabled
+  GDBusConnection *login1_bus;
+  guint            login1_lock_sub;
+  guint            login1_sleep_sub;
+
+  /* Finger presence, as last reported to libfprint */
+  FpFingerStatusFlags   finger_status;
+  gint64                finger_touch_time;   // Finger reported present
+  gint64                finger_result_time;  // Finger no longer reported present (result or action end)
+  guint                 finger_reports_suppressed;
+  guint                 finger_bounces;
+  struct elanmoc2_dwell finger_touch_to_result;
+  struct elanmoc2_dwell finger_lift_to_touch;
+
+  /* Runtime power management */
+  int      usbfs_fd;
+  dev_t    usbfs_devnum;
+  gboolean pm_suspend_allowed;
+  gint64   pm_idle_since;
+  guint    pm_resume_count;
+  gint64   pm_resume_last_us;
+  gint64   pm_resume_max_us;
+  gint64   pm_resume_total_us;
+
+  /* Statistics file write scheduled by elanmoc2_stats_schedule_save() */
+  guint stats_save_source;
 };
 
 G_DEFINE_TYPE (FpiDeviceElanMoC2, fpi_device_elanmoc2, FP_TYPE_DEVICE);
 
+/* Counters are only touched with g_atomic_int_*(), so readers never need the device lock */
+struct elanmoc2_stats
+{
+  gint  started[ELANMOC2_OP_NUM];
+  gint  succeeded[ELANMOC2_OP_NUM];
+  gint  failed[ELANMOC2_OP_NUM];
+  gint  responses[ELANMOC2_OP_NUM][256];
+
+  // Touches (finger-wait responses) needed per successful identify/verify
+  gint  touches;
+  gint  touches_since_match;
+  gint  touch_window[ELANMOC2_STATS_TOUCH_WINDOW];
+  guint touch_window_len;
+  guint touch_window_pos;
+};
+
+static struct elanmoc2_stats elanmoc2_stats;
+static gchar *elanmoc2_stats_path;
+
 
 static void
 elanmoc2_cmd_usb_receive_callback (FpiUsbTransfer *transfer, FpDevice *device, gpointer user_data, GError *error)
 {
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
 
+  gint jump_state = self->recv_jump_state;
+
+  self->recv_jump_state = -1;
+
   if (self->ssm == NULL)
     {
       fp_info ("Received USB callback with no ongoing action");
@@ -74,6 +157,14 @@ elanmoc2_cmd_usb_receive_callback (FpiUsbTransfer *transfer, FpDevice *device, g
       return;
     }
 
+  if (error && self->identify_empty && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) &&
+      !g_cancellable_is_cancelled (fpi_device_get_cancellable (device)))
+    {
+      // The driver ended the finger wait of an empty sensor itself (elanmoc2_identify_abort_timeout_cb())
+      fp_info ("Finger wait ended by the driver");
+      g_clear_error (&error);
+    }
+
   if (error)
     {
       fpi_ssm_mark_failed (g_steal_pointer (&self->ssm), error);
@@ -96,7 +187,10 @@ elanmoc2_cmd_usb_receive_callback (FpiUsbTransfer *transfer, FpDevice *device, g
       self->buffer_in = g_malloc0 (transfer->actual_length + 1);
       memcpy (self->buffer_in, transfer->buffer, transfer->actual_length);
       self->buffer_in_len = transfer->actual_length;
-      fpi_ssm_next_state (self->ssm);
+      if (jump_state >= 0)
+        fpi_ssm_jump_to_state (self->ssm, jump_state);
+      else
+        fpi_ssm_next_state (self->ssm);
     }
 }
 
@@ -110,6 +204,28 @@ elanmoc2_cmd_send_sync (FpDevice *device, const struct elanmoc2_cmd *cmd, guint8
   return fpi_usb_transfer_submit_sync (transfer_out, ELANMOC2_USB_SEND_TIMEOUT, error);
 }
 
+/**
+ * Cancellable for the finger-wait commands. Once the action is cancelled its own cancellable is used, so a wait
+ * submitted afterwards ends at once. A cancellable the driver cancelled itself is replaced for the next wait.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @return Cancellable, owned by the device
+ */
+static GCancellable *
+elanmoc2_wait_cancellable (FpiDeviceElanMoC2 *self)
+{
+  GCancellable *action_cancellable = fpi_device_get_cancellable (FP_DEVICE (self));
+
+  if (g_cancellable_is_cancelled (action_cancellable))
+    return action_cancellable;
+
+  if (self->wait_cancellable == NULL || g_cancellable_is_cancelled (self->wait_cancellable))
+    {
+      g_clear_object (&self->wait_cancellable);
+      self->wait_cancellable = g_cancellable_new ();
+    }
+  return self->wait_cancellable;
+}
+
 static void
 elanmoc2_cmd_transceive (FpDevice *device, FpiSsm *ssm, const struct elanmoc2_cmd *cmd, guint8 *buffer_out)
 {
@@ -119,7 +235,11 @@ elanmoc2_cmd_transceive (FpDevice *device, FpiSsm *ssm, const struct elanmoc2_cm
   gboolean send_status = elanmoc2_cmd_send_sync (device, cmd, g_steal_pointer (&buffer_out), &error);
 
   if (!send_status)
-    return fpi_ssm_mark_failed (g_steal_pointer (&self->ssm), error);
+    {
+      // No response will come for elanmoc2_cmd_transceive_to_state(): don't leave its state for the next operation
+      self->recv_jump_state = -1;
+      return fpi_ssm_mark_failed (g_steal_pointer (&self->ssm), error);
+    }
 
   if (cmd->in_len == 0)
     // Nothing to receive
@@ -132,11 +252,152 @@ elanmoc2_cmd_transceive (FpDevice *device, FpiSsm *ssm, const struct elanmoc2_cm
   fpi_usb_transfer_fill_bulk (transfer_in, cmd->ep_in, cmd->in_len);
   fpi_usb_transfer_submit (transfer_in,
                            ELANMOC2_USB_RECV_TIMEOUT,
-                           cmd->cancellable ? fpi_device_get_cancellable (device) : NULL,
+                           cmd->cancellable ? elanmoc2_wait_cancellable (self) : NULL,
                            elanmoc2_cmd_usb_receive_callback,
                            NULL);
 }
 
+/**
+ * Like elanmoc2_cmd_transceive(), but the response is delivered to an explicit state instead of the next one.
+ * This allows a state to submit a command while it is still handling the previous response.
+ * @param device FpDevice
+ * @param ssm Current state machine
+ * @param cmd Command to send
+ * @param buffer_out Prepared command buffer, ownership is taken
+ * @param state State to jump to once the response has been received
+ */
+static void
+elanmoc2_cmd_transceive_to_state (FpDevice *device, FpiSsm *ssm, const struct elanmoc2_cmd *cmd, guint8 *buffer_out,
+                                  gint state)
+{
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
+
+  self->recv_jump_state = state;
+  elanmoc2_cmd_transceive (device, ssm, cmd, g_steal_pointer (&buffer_out));
+}
+
+typedef void (*elanmoc2_quick_callback) (FpiDeviceElanMoC2 *self, GError *error);
+
+struct elanmoc2_quick_query
+{
+  guint                      op_serial;
+  const struct elanmoc2_cmd *cmd;  // NULL for a barrier: the callback runs once the queries before it are done
+  guint8                    *buffer_out;
+  elanmoc2_quick_callback    callback;
+};
+
+static void
+elanmoc2_quick_query_free (struct elanmoc2_quick_query *query)
+{
+  g_free (query->buffer_out);
+  g_free (query);
+}
+
+static void elanmoc2_quick_dispatch (FpiDeviceElanMoC2 *self);
+
+static void
+elanmoc2_quick_receive_callback (FpiUsbTransfer *transfer, FpDevice *device, gpointer user_data, GError *error)
+{
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
+  struct elanmoc2_quick_query *query = user_data;
+
+  if (query->op_serial != self->op_serial)
+    {
+      fp_dbg ("Dropping quick response received after its operation ended");
+      g_clear_error (&error);
+    }
+  else
+    {
+      if (!error && (transfer->actual_length < 2 || transfer->buffer[0] != 0x40))
+        error = fpi_device_error_new_msg (FP_DEVICE_ERROR_PROTO, "Error receiving data from sensor");
+
+      if (!error)
+        {
+          self->quick_buffer_in = g_memdup2 (transfer->buffer, transfer->actual_length);
+          self->quick_buffer_in_len = transfer->actual_length;
+        }
+      query->callback (self, error);
+      g_clear_pointer (&self->quick_buffer_in, g_free);
+    }
+
+  elanmoc2_quick_query_free (query);
+  self->quick_busy = FALSE;
+  elanmoc2_quick_dispatch (self);
+}
+
+/**
+ * Sends the next queued quick query, unless one is in flight: EP 0x83 answers in order, so two outstanding reads
+ * could each get the other's response. Queries of an operation that ended are dropped, barriers complete here.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_quick_dispatch (FpiDeviceElanMoC2 *self)
+{
+  FpDevice *device = FP_DEVICE (self);
+  struct elanmoc2_quick_query *query;
+
+  if (self->quick_busy)
+    return;
+
+  // Callbacks run below may queue more queries, this loop sends them
+  self->quick_busy = TRUE;
+  while ((query = g_queue_pop_head (&self->quick_queue)) != NULL)
+    {
+      GError *error = NULL;
+
+      if (query->op_serial != self->op_serial)
+        {
+          fp_dbg ("Dropping quick query queued by an operation that ended");
+        }
+      else if (query->cmd == NULL)
+        {
+          query->callback (self, NULL);
+        }
+      else if (!elanmoc2_cmd_send_sync (device, query->cmd, g_steal_pointer (&query->buffer_out), &error))
+        {
+          query->callback (self, error);
+        }
+      else
+        {
+          FpiUsbTransfer *transfer_in = fpi_usb_transfer_new (device);
+
+          transfer_in->short_is_error = FALSE;
+          fpi_usb_transfer_fill_bulk (transfer_in, query->cmd->ep_in, query->cmd->in_len);
+          fpi_usb_transfer_submit (transfer_in, ELANMOC2_USB_QUICK_RECV_TIMEOUT, NULL, elanmoc2_quick_receive_callback,
+                                   query);
+          return;
+        }
+      elanmoc2_quick_query_free (query);
+    }
+  self->quick_busy = FALSE;
+}
+
+/**
+ * Queues a quick command, its response is received on ELANMOC2_EP_CMD_IN outside of the state machine: the
+ * finger-wait command pending on ELANMOC2_EP_MOC_CMD_IN and self->buffer_in are left alone, so the sensor stays
+ * armed. Quick queries run one at a time in order. The response is handed to the callback in
+ * self->quick_buffer_in, unless the operation ended meanwhile.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @param cmd Quick command (its response must come on ELANMOC2_EP_CMD_IN), or NULL for a barrier
+ * @param buffer_out Prepared command buffer, ownership is taken
+ * @param callback Called with the response or an error, which it owns
+ */
+static void
+elanmoc2_quick_query (FpiDeviceElanMoC2 *self, const struct elanmoc2_cmd *cmd, guint8 *buffer_out,
+                      elanmoc2_quick_callback callback)
+{
+  struct elanmoc2_quick_query *query = g_new0 (struct elanmoc2_quick_query, 1);
+
+  g_assert (cmd == NULL || (cmd->ep_in == ELANMOC2_EP_CMD_IN && !cmd->cancellable));
+
+  query->op_serial = self->op_serial;
+  query->cmd = cmd;
+  query->buffer_out = g_steal_pointer (&buffer_out);
+  query->callback = callback;
+  g_queue_push_tail (&self->quick_queue, query);
+  elanmoc2_quick_dispatch (self);
+}
+
 static uint8_t *
 elanmoc2_prepare_cmd (FpiDeviceElanMoC2 *self, const struct elanmoc2_cmd *cmd)
 {
@@ -222,32 +483,637 @@ elanmoc2_print_new_from_finger_info (FpiDeviceElanMoC2 *self, guint8 finger_id,
       fp_info ("Creating new print: finger %d, user id[%d]: raw data", finger_id, user_id_len);
     }
 
-  FpPrint *print = elanmoc2_print_new_with_user_id (self, finger_id, user_id_len, user_id);
+  FpPrint *print = elanmoc2_print_new_with_user_id (self, finger_id, user_id_len, user_id);
+
+  if (!fpi_print_fill_from_user_id (print, (const char *) user_id))
+    {
+      // Fingerprint matched with on-sensor print, but the on-sensor print was not added by libfprint.
+      // Wipe it and report a failure.
+      fp_info ("Finger info not generated by libfprint");
+    }
+  else
+    {
+      fp_info ("Finger info with libfprint user ID");
+    }
+
+  return g_steal_pointer (&print);
+}
+
+static gboolean
+elanmoc2_finger_info_is_present (FpiDeviceElanMoC2 *self, const guint8 *finger_info_response)
+{
+  // Report true if the user ID was set by libfprint. This is not accurate since after wiping the sensor the user IDs
+  // are not reset.
+  const gchar *user_id = self->dev_type == ELANMOC2_DEV_0C5E ?
+                         (gchar *) &finger_info_response[3] :
+                         (gchar *) &finger_info_response[2];
+
+  return memcmp (user_id, "FP1-", 4) == 0;
+}
+
+
+static gboolean
+elanmoc2_pm_is_suspended (FpiDeviceElanMoC2 *self)
+{
+  g_autofree gchar *path = g_strdup_printf ("/sys/dev/char/%u:%u/power/runtime_status",
+                                            major (self->usbfs_devnum), minor (self->usbfs_devnum));
+  g_autofree gchar *status = NULL;
+
+  if (!g_file_get_contents (path, &status, NULL, NULL))
+    return FALSE;
+
+  return g_str_has_prefix (status, "suspended");
+}
+
+/**
+ * Sets up USB autosuspend for the sensor. GUsb doesn't expose the usbfs file descriptor libusb opened for the
+ * device, so it is looked up in /proc/self/fd by device number. An open usbfs descriptor keeps the device awake
+ * until USBDEVFS_ALLOW_SUSPEND is issued on it. The sysfs side (power/control, autosuspend delay) is set by the
+ * udev rule installed with the driver, fprintd can't write it under ProtectKernelTunables.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_pm_init (FpiDeviceElanMoC2 *self)
+{
+  self->usbfs_fd = -1;
+  self->pm_suspend_allowed = FALSE;
+
+#ifdef USBDEVFS_ALLOW_SUSPEND
+  GUsbDevice *usb_device = fpi_device_get_usb_device (FP_DEVICE (self));
+  g_autoptr(GDir) fd_dir = NULL;
+  const gchar *fd_name;
+
+  if (g_strcmp0 (g_getenv (ELANMOC2_AUTOSUSPEND_ENV), "0") == 0)
+    {
+      fp_info ("Runtime PM: disabled by %s", ELANMOC2_AUTOSUSPEND_ENV);
+      return;
+    }
+
+  self->usbfs_devnum = makedev (ELANMOC2_USB_DEVICE_MAJOR,
+                                (g_usb_device_get_bus (usb_device) - 1) * 128 + g_usb_device_get_address (usb_device) - 1);
+
+  if ((fd_dir = g_dir_open ("/proc/self/fd", 0, NULL)) == NULL)
+    return;
+
+  while ((fd_name = g_dir_read_name (fd_dir)) != NULL)
+    {
+      struct stat st;
+      int fd = (int) g_ascii_strtoll (fd_name, NULL, 10);
+
+      if (fstat (fd, &st) == 0 && S_ISCHR (st.st_mode) && st.st_rdev == self->usbfs_devnum)
+        {
+          self->usbfs_fd = fd;
+          break;
+        }
+    }
+
+  if (self->usbfs_fd < 0)
+    {
+      fp_info ("Runtime PM: usbfs descriptor not found, sensor stays powered");
+      return;
+    }
+
+  fp_info ("Runtime PM: autosuspend allowed between operations");
+#else
+  fp_info ("Runtime PM: not supported by the kernel headers this driver was built with");
+#endif
+}
+
+/**
+ * Lets the kernel autosuspend the sensor. Called whenever no state machine is running.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_pm_allow_suspend (FpiDeviceElanMoC2 *self)
+{
+#ifdef USBDEVFS_ALLOW_SUSPEND
+  if (self->usbfs_fd < 0 || self->pm_suspend_allowed)
+    return;
+
+  if (ioctl (self->usbfs_fd, USBDEVFS_ALLOW_SUSPEND) < 0)
+    {
+      fp_warn ("Runtime PM: failed to allow suspend: %s", g_strerror (errno));
+      return;
+    }
+
+  self->pm_suspend_allowed = TRUE;
+  self->pm_idle_since = g_get_monotonic_time ();
+#endif
+}
+
+/**
+ * Keeps the sensor powered for a new operation, resuming it first if it was suspended. The ioctl only returns once
+ * the device is resumed, so its duration is the latency cost of the suspend.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_pm_wake (FpiDeviceElanMoC2 *self)
+{
+#ifdef USBDEVFS_ALLOW_SUSPEND
+  if (self->usbfs_fd < 0 || !self->pm_suspend_allowed)
+    return;
+
+  gboolean was_suspended = elanmoc2_pm_is_suspended (self);
+  gint64 start = g_get_monotonic_time ();
+
+  if (ioctl (self->usbfs_fd, USBDEVFS_FORBID_SUSPEND) < 0)
+    fp_warn ("Runtime PM: failed to resume sensor: %s", g_strerror (errno));
+
+  gint64 wake_us = g_get_monotonic_time () - start;
+  gint64 idle_ms = (start - self->pm_idle_since) / 1000;
+
+  self->pm_suspend_allowed = FALSE;
+  if (!was_suspended)
+    {
+      fp_dbg ("Runtime PM: sensor still awake after %" G_GINT64_FORMAT " ms idle", idle_ms);
+      return;
+    }
+
+  self->pm_resume_count++;
+  self->pm_resume_last_us = wake_us;
+  self->pm_resume_total_us += wake_us;
+  self->pm_resume_max_us = MAX (self->pm_resume_max_us, wake_us);
+  fp_message ("Runtime PM: resumed after %" G_GINT64_FORMAT " ms idle in %" G_GINT64_FORMAT " us "
+              "(resumes: %u, avg: %" G_GINT64_FORMAT " us, max: %" G_GINT64_FORMAT " us)",
+           idle_ms, wake_us, self->pm_resume_count, self->pm_resume_total_us / self->pm_resume_count,
+           self->pm_resume_max_us);
+#endif
+}
+
+
+static gdouble
+elanmoc2_stats_touches_per_match (void)
+{
+  gint sum = 0;
+
+  if (elanmoc2_stats.touch_window_len == 0)
+    return 0;
+
+  for (guint i = 0; i < elanmoc2_stats.touch_window_len; i++)
+    sum += g_atomic_int_get (&elanmoc2_stats.touch_window[i]);
+
+  return (gdouble) sum / elanmoc2_stats.touch_window_len;
+}
+
+/**
+ * Loads the statistics persisted by a previous open. The path is ELANMOC2_STATS_FILE, or ELANMOC2_STATS_FILE_ENV
+ * from fprintd's environment.
+ * @param self FpiDeviceElanMoC2 pointer, for the runtime PM counters it keeps
+ */
+static void
+elanmoc2_stats_load (FpiDeviceElanMoC2 *self)
+{
+  g_autoptr(GKeyFile) key_file = g_key_file_new ();
+  g_autoptr(GError) error = NULL;
+  const gchar *path_env = g_getenv (ELANMOC2_STATS_FILE_ENV);
+
+  g_clear_pointer (&elanmoc2_stats_path, g_free);
+  elanmoc2_stats_path = g_strdup (path_env ? path_env : ELANMOC2_STATS_FILE);
+  memset (&elanmoc2_stats, 0, sizeof (elanmoc2_stats));
+
+  if (!g_key_file_load_from_file (key_file, elanmoc2_stats_path, G_KEY_FILE_NONE, &error))
+    {
+      fp_dbg ("No previous statistics in %s: %s", elanmoc2_stats_path, error->message);
+      return;
+    }
+
+  for (int op = 0; op < ELANMOC2_OP_NUM; op++)
+    {
+      const gchar *group = elanmoc2_stats_op_names[op];
+      g_auto(GStrv) keys = g_key_file_get_keys (key_file, group, NULL, NULL);
+
+      for (gchar **key = keys; key && *key; key++)
+        {
+          gint value = g_key_file_get_integer (key_file, group, *key, NULL);
+
+          if (g_str_equal (*key, "started"))
+            elanmoc2_stats.started[op] = value;
+          else if (g_str_equal (*key, "succeeded"))
+            elanmoc2_stats.succeeded[op] = value;
+          else if (g_str_equal (*key, "failed"))
+            elanmoc2_stats.failed[op] = value;
+          else if (g_str_has_prefix (*key, "response_0x"))
+            elanmoc2_stats.responses[op][g_ascii_strtoull (*key + strlen ("response_0x"), NULL, 16) & 0xff] = value;
+        }
+    }
+
+  gsize window_len = 0;
+  g_autofree gint *window = g_key_file_get_integer_list (key_file, "touches", "window", &window_len, NULL);
+
+  elanmoc2_stats.touches = g_key_file_get_integer (key_file, "touches", "total", NULL);
+  elanmoc2_stats.touches_since_match = g_key_file_get_integer (key_file, "touches", "since_last_match", NULL);
+  elanmoc2_stats.touch_window_len = MIN (window_len, ELANMOC2_STATS_TOUCH_WINDOW);
+  elanmoc2_stats.touch_window_pos = elanmoc2_stats.touch_window_len % ELANMOC2_STATS_TOUCH_WINDOW;
+  for (guint i = 0; i < elanmoc2_stats.touch_window_len; i++)
+    elanmoc2_stats.touch_window[i] = window[i];
+
+  self->pm_resume_count = g_key_file_get_integer (key_file, "runtime_pm", "resumes", NULL);
+  self->pm_resume_last_us = g_key_file_get_int64 (key_file, "runtime_pm", "resume_last_us", NULL);
+  self->pm_resume_max_us = g_key_file_get_int64 (key_file, "runtime_pm", "resume_max_us", NULL);
+  self->pm_resume_total_us = g_key_file_get_int64 (key_file, "runtime_pm", "resume_total_us", NULL);
+  // Files written before resume_total_us existed only have the average
+  if (!g_key_file_has_key (key_file, "runtime_pm", "resume_total_us", NULL))
+    self->pm_resume_total_us = g_key_file_get_int64 (key_file, "runtime_pm", "resume_avg_us", NULL) *
+                               self->pm_resume_count;
+}
+
+static void
+elanmoc2_stats_save_dwell (GKeyFile *key_file, const gchar *name, const struct elanmoc2_dwell *dwell)
+{
+  g_autofree gchar *count = g_strdup_printf ("%s_count", name);
+  g_autofree gchar *last = g_strdup_printf ("%s_last_ms", name);
+  g_autofree gchar *avg = g_strdup_printf ("%s_avg_ms", name);
+  g_autofree gchar *max = g_strdup_printf ("%s_max_ms", name);
+
+  g_key_file_set_integer (key_file, "finger", count, dwell->count);
+  g_key_file_set_int64 (key_file, "finger", last, dwell->last_ms);
+  g_key_file_set_int64 (key_file, "finger", avg, dwell->count ? dwell->total_ms / dwell->count : 0);
+  g_key_file_set_int64 (key_file, "finger", max, dwell->max_ms);
+}
+
+/**
+ * Writes the statistics as a key file. g_key_file_save_to_file() renames a temporary file over the previous one, so
+ * readers never see a partial file.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_stats_save (FpiDeviceElanMoC2 *self)
+{
+  g_autoptr(GKeyFile) key_file = g_key_file_new ();
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *dir = NULL;
+  gint window[ELANMOC2_STATS_TOUCH_WINDOW];
+
+  if (elanmoc2_stats_path == NULL)
+    return;
+
+  for (int op = 0; op < ELANMOC2_OP_NUM; op++)
+    {
+      const gchar *group = elanmoc2_stats_op_names[op];
+
+      g_key_file_set_integer (key_file, group, "started", g_atomic_int_get (&elanmoc2_stats.started[op]));
+      g_key_file_set_integer (key_file, group, "succeeded", g_atomic_int_get (&elanmoc2_stats.succeeded[op]));
+      g_key_file_set_integer (key_file, group, "failed", g_atomic_int_get (&elanmoc2_stats.failed[op]));
+
+      for (int code = 0; code < 256; code++)
+        {
+          gint count = g_atomic_int_get (&elanmoc2_stats.responses[op][code]);
+          g_autofree gchar *key = NULL;
+
+          if (count == 0)
+            continue;
+
+          key = g_strdup_printf ("response_0x%02x", code);
+          g_key_file_set_integer (key_file, group, key, count);
+        }
+    }
+
+  // Oldest first, so the list reads chronologically
+  for (guint i = 0; i < elanmoc2_stats.touch_window_len; i++)
+    {
+      guint start = elanmoc2_stats.touch_window_len < ELANMOC2_STATS_TOUCH_WINDOW ? 0 : elanmoc2_stats.touch_window_pos;
+      window[i] = g_atomic_int_get (&elanmoc2_stats.touch_window[(start + i) % ELANMOC2_STATS_TOUCH_WINDOW]);
+    }
+
+  g_key_file_set_integer (key_file, "touches", "total", g_atomic_int_get (&elanmoc2_stats.touches));
+  g_key_file_set_integer (key_file, "touches", "since_last_match", g_atomic_int_get (&elanmoc2_stats.touches_since_match));
+  g_key_file_set_integer_list (key_file, "touches", "window", window, elanmoc2_stats.touch_window_len);
+  g_key_file_set_double (key_file, "touches", "touches_per_identify", elanmoc2_stats_touches_per_match ());
+
+  g_key_file_set_integer (key_file, "runtime_pm", "resumes", self->pm_resume_count);
+  g_key_file_set_int64 (key_file, "runtime_pm", "resume_last_us", self->pm_resume_last_us);
+  g_key_file_set_int64 (key_file, "runtime_pm", "resume_max_us", self->pm_resume_max_us);
+  g_key_file_set_int64 (key_file, "runtime_pm", "resume_total_us", self->pm_resume_total_us);
+  g_key_file_set_int64 (key_file, "runtime_pm", "resume_avg_us",
+                        self->pm_resume_count ? self->pm_resume_total_us / self->pm_resume_count : 0);
+
+  // Finger presence timings since open, for latency analysis
+  elanmoc2_stats_save_dwell (key_file, "touch_to_result", &self->finger_touch_to_result);
+  elanmoc2_stats_save_dwell (key_file, "lift_to_touch", &self->finger_lift_to_touch);
+  g_key_file_set_integer (key_file, "finger", "bounces", self->finger_bounces);
+  g_key_file_set_integer (key_file, "finger", "reports_suppressed", self->finger_reports_suppressed);
+
+  dir = g_path_get_dirname (elanmoc2_stats_path);
+  g_mkdir_with_parents (dir, 0755);
+  if (!g_key_file_save_to_file (key_file, elanmoc2_stats_path, &error))
+    fp_warn ("Could not write statistics to %s: %s", elanmoc2_stats_path, error->message);
+}
+
+static gboolean
+elanmoc2_stats_save_timeout_cb (gpointer user_data)
+{
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (user_data);
+
+  self->stats_save_source = 0;
+  elanmoc2_stats_save (self);
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Saves the statistics ELANMOC2_STATS_SAVE_DELAY_S seconds after the first operation that changed them, so a burst
+ * of operations (retries, identify then verify) costs one write instead of one per operation.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_stats_schedule_save (FpiDeviceElanMoC2 *self)
+{
+  if (self->stats_save_source == 0)
+    self->stats_save_source = g_timeout_add_seconds (ELANMOC2_STATS_SAVE_DELAY_S,
+                                                     elanmoc2_stats_save_timeout_cb, self);
+}
+
+/**
+ * Writes any scheduled save now. Called on close, before the device goes away.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_stats_flush (FpiDeviceElanMoC2 *self)
+{
+  if (self->stats_save_source == 0)
+    return;
+
+  g_clear_handle_id (&self->stats_save_source, g_source_remove);
+  elanmoc2_stats_save (self);
+}
+
+static void
+elanmoc2_stats_op_started (FpiDeviceElanMoC2 *self, enum elanmoc2_stats_op op)
+{
+  self->stats_op = op;
+  g_atomic_int_inc (&elanmoc2_stats.started[op]);
+}
+
+static void
+elanmoc2_stats_op_succeeded (FpiDeviceElanMoC2 *self)
+{
+  g_atomic_int_inc (&elanmoc2_stats.succeeded[self->stats_op]);
+}
+
+static void
+elanmoc2_stats_op_failed (FpiDeviceElanMoC2 *self)
+{
+  g_atomic_int_inc (&elanmoc2_stats.failed[self->stats_op]);
+}
+
+/**
+ * Closes the current touches-per-match sample after a successful identify/verify.
+ */
+static void
+elanmoc2_stats_match (FpiDeviceElanMoC2 *self)
+{
+  gint touches = g_atomic_int_get (&elanmoc2_stats.touches_since_match);
+
+  g_atomic_int_set (&elanmoc2_stats.touches_since_match, 0);
+  g_atomic_int_set (&elanmoc2_stats.touch_window[elanmoc2_stats.touch_window_pos], touches);
+  elanmoc2_stats.touch_window_pos = (elanmoc2_stats.touch_window_pos + 1) % ELANMOC2_STATS_TOUCH_WINDOW;
+  elanmoc2_stats.touch_window_len = MIN (elanmoc2_stats.touch_window_len + 1, ELANMOC2_STATS_TOUCH_WINDOW);
+  elanmoc2_stats_op_succeeded (self);
+  fp_info ("Matched after %d touches (rolling average: %.2f)", touches, elanmoc2_stats_touches_per_match ());
+}
+
+static void
+elanmoc2_dwell_add (struct elanmoc2_dwell *dwell, gint64 ms)
+{
+  dwell->count++;
+  dwell->last_ms = ms;
+  dwell->total_ms += ms;
+  dwell->max_ms = MAX (dwell->max_ms, ms);
+}
+
+/**
+ * Reports a finger presence change to libfprint, but only on a real transition: the state machines report NEEDED on
+ * every resubmit and NONE for every listed print, which would otherwise reach fprintd as a stream of identical
+ * notifications. Leaving PRESENT closes a touch-to-result sample; the next touch closes a lift-to-next-touch sample,
+ * unless it comes within ELANMOC2_FINGER_LIFT_MIN_MS (the finger never left the sensor, counted as a bounce).
+ * @param self FpiDeviceElanMoC2 pointer
+ * @param status New finger status
+ */
+static void
+elanmoc2_finger_status (FpiDeviceElanMoC2 *self, FpFingerStatusFlags status)
+{
+  gint64 now;
+
+  if (status == self->finger_status)
+    {
+      self->finger_reports_suppressed++;
+      return;
+    }
+
+  now = g_get_monotonic_time ();
+  if (status == FP_FINGER_STATUS_PRESENT)
+    {
+      gint64 lift_ms = (now - self->finger_result_time) / 1000;
+
+      // Nothing to measure on the first touch since open
+      if (self->finger_result_time != 0 && lift_ms < ELANMOC2_FINGER_LIFT_MIN_MS)
+        self->finger_bounces++;
+      else if (self->finger_result_time != 0)
+        elanmoc2_dwell_add (&self->finger_lift_to_touch, lift_ms);
+      self->finger_touch_time = now;
+    }
+  else if (self->finger_status == FP_FINGER_STATUS_PRESENT)
+    {
+      elanmoc2_dwell_add (&self->finger_touch_to_result, (now - self->finger_touch_time) / 1000);
+      self->finger_result_time = now;
+      fp_dbg ("Finger: touch resolved in %" G_GINT64_FORMAT " ms", self->finger_touch_to_result.last_ms);
+    }
+
+  self->finger_status = status;
+  fpi_device_report_finger_status (FP_DEVICE (self), status);
+}
+
+/**
+ * Forgets the reported finger status when an action ends: libfprint clears it itself once the action returns.
+ * A touch still open (cancelled while the finger was on the sensor) is closed first.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_finger_status_reset (FpiDeviceElanMoC2 *self)
+{
+  if (self->finger_status == FP_FINGER_STATUS_PRESENT)
+    {
+      gint64 now = g_get_monotonic_time ();
+
+      elanmoc2_dwell_add (&self->finger_touch_to_result, (now - self->finger_touch_time) / 1000);
+      self->finger_result_time = now;
+    }
+  self->finger_status = FP_FINGER_STATUS_NONE;
+}
+
+/**
+ * Appends a verified-presence cache event to the audit log and the journal. The log lives in fprintd's state
+ * directory, the only one it may write to under ProtectSystem=strict.
+ * @param event store, hit or drop
+ * @param print Enrolled print concerned
+ * @param detail Free-form key=value details
+ * @return TRUE if the event reached the audit log; a hit must not be served otherwise
+ */
+static gboolean
+elanmoc2_verify_cache_audit (const gchar *event, FpPrint *print, const gchar *detail)
+{
+  g_autoptr(GDateTime) now = g_date_time_new_now_local ();
+  g_autofree gchar *stamp = g_date_time_format (now, "%Y-%m-%d %H:%M:%S");
+  g_autofree gchar *line = g_strdup_printf ("event=%s user=%s finger=%d %s", event,
+                                            fp_print_get_username (print) ? fp_print_get_username (print) : "-",
+                                            fp_print_get_finger (print), detail);
+  FILE *log = fopen (ELANMOC2_VERIFY_CACHE_AUDIT_LOG, "a");
+  gboolean written;
+
+  fp_message ("Verify cache: %s", line);
+  if (log == NULL)
+    {
+      fp_warn ("Verify cache: could not open %s: %s", ELANMOC2_VERIFY_CACHE_AUDIT_LOG, g_strerror (errno));
+      return FALSE;
+    }
+  written = fprintf (log, "%s %s\n", stamp, line) > 0;
+  written = fclose (log) == 0 && written;
+  if (!written)
+    fp_warn ("Verify cache: could not write %s: %s", ELANMOC2_VERIFY_CACHE_AUDIT_LOG, g_strerror (errno));
+
+  return written;
+}
+
+/**
+ * Drops the cached match, if any.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @param reason Why, for the audit log
+ */
+static void
+elanmoc2_verify_cache_invalidate (FpiDeviceElanMoC2 *self, const gchar *reason)
+{
+  g_autofree gchar *detail = NULL;
+
+  if (self->verify_cache_print == NULL)
+    return;
+
+  detail = g_strdup_printf ("reason=%s", reason);
+  elanmoc2_verify_cache_audit ("drop", self->verify_cache_print, detail);
+  g_clear_object (&self->verify_cache_print);
+}
+
+/**
+ * Remembers a successful match. Only the enrolled print it matched is kept, and the TTL runs from this touch: hits
+ * don't extend it.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @param print Enrolled print (from the identify gallery or the verify data) that matched
+ */
+static void
+elanmoc2_verify_cache_store (FpiDeviceElanMoC2 *self, FpPrint *print)
+{
+  g_autofree gchar *detail = NULL;
+
+  if (self->verify_cache_ttl_ms <= 0)
+    return;
+
+  g_set_object (&self->verify_cache_print, print);
+  self->verify_cache_time = g_get_monotonic_time ();
+  detail = g_strdup_printf ("ttl_ms=%" G_GINT64_FORMAT, self->verify_cache_ttl_ms);
+  elanmoc2_verify_cache_audit ("store", print, detail);
+}
+
+/**
+ * Looks the current identify/verify request up in the cache.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @return The requested print equal to the cached match (owned by the request), or NULL on a miss
+ */
+static FpPrint *
+elanmoc2_verify_cache_lookup (FpiDeviceElanMoC2 *self)
+{
+  FpDevice *device = FP_DEVICE (self);
+
+  if (self->verify_cache_print == NULL)
+    return NULL;
+
+  if (g_get_monotonic_time () - self->verify_cache_time > self->verify_cache_ttl_ms * 1000)
+    {
+      elanmoc2_verify_cache_invalidate (self, "expired");
+      return NULL;
+    }
+
+  if (fpi_device_get_current_action (device) == FPI_DEVICE_ACTION_IDENTIFY)
+    {
+      GPtrArray *gallery = NULL;
+
+      fpi_device_get_identify_data (device, &gallery);
+      for (guint i = 0; i < gallery->len; i++)
+        if (fp_print_equal (g_ptr_array_index (gallery, i), self->verify_cache_print))
+          return g_ptr_array_index (gallery, i);
+    }
+  else
+    {
+      FpPrint *to_match = NULL;
+
+      fpi_device_get_verify_data (device, &to_match);
+      if (fp_print_equal (to_match, self->verify_cache_print))
+        return to_match;
+    }
+
+  return NULL;
+}
+
+static void
+elanmoc2_verify_cache_login1_cb (GDBusConnection *connection, const gchar *sender, const gchar *path,
+                                 const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data)
+{
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (user_data);
+  gboolean sleeping = TRUE;
 
-  if (!fpi_print_fill_from_user_id (print, (const char *) user_id))
+  if (g_strcmp0 (signal, "Lock") == 0)
     {
-      // Fingerprint matched with on-sensor print, but the on-sensor print was not added by libfprint.
-      // Wipe it and report a failure.
-      fp_info ("Finger info not generated by libfprint");
+      elanmoc2_verify_cache_invalidate (self, "lock");
+      return;
     }
-  else
+
+  g_variant_get (parameters, "(b)", &sleeping);
+  if (sleeping)
+    elanmoc2_verify_cache_invalidate (self, "suspend");
+}
+
+/**
+ * Enables the cache if ELANMOC2_VERIFY_CACHE_TTL_MS is set, and subscribes to the logind Lock and PrepareForSleep
+ * signals that must drop it. Without the system bus the cache stays disabled.
+ * @param self FpiDeviceElanMoC2 pointer
+ */
+static void
+elanmoc2_verify_cache_init (FpiDeviceElanMoC2 *self)
+{
+  const gchar *ttl_env = g_getenv (ELANMOC2_VERIFY_CACHE_TTL_ENV);
+  g_autoptr(GError) error = NULL;
+
+  self->verify_cache_ttl_ms = ttl_env ? CLAMP (g_ascii_strtoll (ttl_env, NULL, 10), 0,
+                                               ELANMOC2_VERIFY_CACHE_TTL_MAX_MS) : 0;
+  if (self->verify_cache_ttl_ms == 0)
+    return;
+
+  if ((self->login1_bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error)) == NULL)
     {
-      fp_info ("Finger info with libfprint user ID");
+      fp_warn ("Verify cache: disabled, cannot watch lock and suspend: %s", error->message);
+      self->verify_cache_ttl_ms = 0;
+      return;
     }
 
-  return g_steal_pointer (&print);
+  self->login1_lock_sub = g_dbus_connection_signal_subscribe (self->login1_bus, "org.freedesktop.login1",
+                                                              "org.freedesktop.login1.Session", "Lock", NULL, NULL,
+                                                              G_DBUS_SIGNAL_FLAGS_NONE,
+                                                              elanmoc2_verify_cache_login1_cb, self, NULL);
+  self->login1_sleep_sub = g_dbus_connection_signal_subscribe (self->login1_bus, "org.freedesktop.login1",
+                                                               "org.freedesktop.login1.Manager", "PrepareForSleep",
+                                                               "/org/freedesktop/login1", NULL,
+                                                               G_DBUS_SIGNAL_FLAGS_NONE,
+                                                               elanmoc2_verify_cache_login1_cb, self, NULL);
+  fp_info ("Verify cache: enabled, matches reused for %" G_GINT64_FORMAT " ms", self->verify_cache_ttl_ms);
 }
 
-static gboolean
-elanmoc2_finger_info_is_present (FpiDeviceElanMoC2 *self, const guint8 *finger_info_response)
+static void
+elanmoc2_verify_cache_clear (FpiDeviceElanMoC2 *self)
 {
-  // Report true if the user ID was set by libfprint. This is not accurate since after wiping the sensor the user IDs
-  // are not reset.
-  const gchar *user_id = self->dev_type == ELANMOC2_DEV_0C5E ?
-                         (gchar *) &finger_info_response[3] :
-                         (gchar *) &finger_info_response[2];
+  elanmoc2_verify_cache_invalidate (self, "close");
+  if (self->login1_bus == NULL)
+    return;
 
-  return memcmp (user_id, "FP1-", 4) == 0;
+  g_dbus_connection_signal_unsubscribe (self->login1_bus, self->login1_lock_sub);
+  g_dbus_connection_signal_unsubscribe (self->login1_bus, self->login1_sleep_sub);
+  g_clear_object (&self->login1_bus);
 }
 
 
@@ -257,6 +1123,8 @@ elanmoc2_cancel (FpDevice *device)
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
 
   fp_info ("Cancelling any ongoing requests");
+  elanmoc2_verify_cache_invalidate (self, "cancel");
+  g_cancellable_cancel (self->wait_cancellable);
 
   GError *error = NULL;
   g_autofree uint8_t *buffer_out = elanmoc2_prepare_cmd (self, &cmd_abort);
@@ -284,16 +1152,28 @@ elanmoc2_open (FpDevice *device)
 
   self = FPI_DEVICE_ELANMOC2 (device);
   self->dev_type = fpi_device_get_driver_data (FP_DEVICE (device));
+  elanmoc2_pm_init (self);
+  elanmoc2_pm_allow_suspend (self);
+  elanmoc2_stats_load (self);
+  elanmoc2_verify_cache_init (self);
   fpi_device_open_complete (device, NULL);
 }
 
 static void
 elanmoc2_close (FpDevice *device)
 {
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
   GError *error = NULL;
 
   fp_info ("Closing device");
+  elanmoc2_pm_wake (self);
+  self->usbfs_fd = -1;
   elanmoc2_cancel (device);
+  g_clear_object (&self->wait_cancellable);
+  g_clear_handle_id (&self->identify_abort_source, g_source_remove);
+  g_queue_clear_full (&self->quick_queue, (GDestroyNotify) elanmoc2_quick_query_free);
+  elanmoc2_verify_cache_clear (self);
+  elanmoc2_stats_flush (self);
   g_usb_device_release_interface (fpi_device_get_usb_device (FP_DEVICE (device)), 0, 0, &error);
   fpi_device_close_complete (device, error);
 }
@@ -301,6 +1181,19 @@ elanmoc2_close (FpDevice *device)
 static void
 elanmoc2_ssm_completed_callback (FpiSsm *ssm, FpDevice *device, GError *error)
 {
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
+
+  self->op_serial++;
+  g_clear_handle_id (&self->identify_abort_source, g_source_remove);
+  elanmoc2_finger_status_reset (self);
+  if (error)
+    elanmoc2_stats_op_failed (self);
+  else if (self->stats_op == ELANMOC2_OP_LIST || self->stats_op == ELANMOC2_OP_DELETE ||
+           self->stats_op == ELANMOC2_OP_CLEAR_STORAGE)
+    elanmoc2_stats_op_succeeded (self);
+  elanmoc2_stats_schedule_save (self);
+  elanmoc2_pm_allow_suspend (self);
+
   if (error)
     fpi_device_action_error (device, error);
 }
@@ -320,78 +1213,75 @@ elanmoc2_perform_get_num_enrolled (FpiDeviceElanMoC2 *self, FpiSsm *ssm)
 }
 
 /**
- * Checks a command status code and, if an error has occurred, creates a new error object.
- * Returns whether the operation needs to be retried..
- * @param self FpiDeviceElanMoC2 pointer
- * @param error A pointer where the GError will be placed in case of errors
- * @return Whether the current action should be retried
+ * Looks up how a response status code should be handled. Pure table lookup, nothing is allocated.
+ * @param code Status code, usually the second byte of the response
+ * @param kind What the response answers, which decides how low status codes are read
+ * @return Classification entry, never NULL
  */
-static gboolean
-elanmoc2_get_finger_error (FpiDeviceElanMoC2 *self, GError **error)
+static const struct elanmoc2_resp_class *
+elanmoc2_classify_response (unsigned char code, enum elanmoc2_resp_kind kind)
 {
-  g_assert (self->buffer_in != NULL);
+  if (kind == ELANMOC2_RESP_KIND_COMMAND && code == 0)
+    return &elanmoc2_resp_progress;
+  if (kind == ELANMOC2_RESP_KIND_CAPTURE && (code == ELANMOC2_RESP_STAGE_OK || code == ELANMOC2_RESP_STAGE_CAPTURED))
+    return &elanmoc2_resp_progress;
 
-  // Regular status codes never have the most-significant nibble set; errors do
-  if ((self->buffer_in[1] & 0xF0) == 0)
+  if ((code & 0xF0) == 0)
     {
-      *error = NULL;
-      return TRUE;
+      if (kind == ELANMOC2_RESP_KIND_CAPTURE)
+        return &elanmoc2_resp_capture_rejected;
+      if (kind == ELANMOC2_RESP_KIND_COMMAND)
+        return &elanmoc2_resp_command_failed;
+      return &elanmoc2_resp_progress;
     }
-  switch ((unsigned char) self->buffer_in[1])
-    {
-    case ELANMOC2_RESP_MOVE_DOWN:
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_CENTER_FINGER,
-                                         "Move your finger slightly downwards");
-      return TRUE;
-
-    case ELANMOC2_RESP_MOVE_RIGHT:
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_CENTER_FINGER,
-                                         "Move your finger slightly to the right");
-      return TRUE;
-
-    case ELANMOC2_RESP_MOVE_UP:
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_CENTER_FINGER,
-                                         "Move your finger slightly upwards");
-      return TRUE;
 
-    case ELANMOC2_RESP_MOVE_LEFT:
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_CENTER_FINGER,
-                                         "Move your finger slightly to the left");
-      return TRUE;
+  for (gsize i = 0; i < G_N_ELEMENTS (elanmoc2_resp_classes); i++)
+    if (elanmoc2_resp_classes[i].code == code)
+      return &elanmoc2_resp_classes[i];
 
-    case ELANMOC2_RESP_SENSOR_DIRTY:
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_REMOVE_FINGER,
-                                         "Sensor is dirty or wet");
-      return TRUE;
+  fp_info ("Unknown response code: 0x%02x", code);
+  return &elanmoc2_resp_unknown;
+}
 
-    case ELANMOC2_RESP_NOT_ENOUGH_SURFACE:
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_REMOVE_FINGER,
-                                         "Press your finger slightly harder on the sensor");
-      return TRUE;
+/**
+ * Creates the retry error libfprint expects for a retry hint. Every retry is reported, each one tells the user to
+ * act again. libfprint takes ownership of the error, so it can't be static: it is built from the static
+ * classification entry without formatting.
+ * @param resp Classification of the response
+ * @return A new retry error
+ */
+static GError *
+elanmoc2_resp_retry_error (const struct elanmoc2_resp_class *resp)
+{
+  return g_error_new_literal (FP_DEVICE_RETRY, resp->retry, resp->hint);
+}
 
-    case ELANMOC2_RESP_NOT_ENROLLED:
-      *error = fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_NOT_FOUND,
-                                         "Finger not recognized");
-      return FALSE;
+static GError *
+elanmoc2_resp_fatal_error (const struct elanmoc2_resp_class *resp)
+{
+  return g_error_new_literal (FP_DEVICE_ERROR, resp->error, resp->hint);
+}
 
-    case ELANMOC2_RESP_MAX_ENROLLED_REACHED:
-      *error = fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_FULL,
-                                         "Maximum number of fingers already enrolled");
-      return FALSE;
+/**
+ * Classifies the response to a finger-wait command and accounts it as a touch in the health statistics.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @param code Status code of the response
+ * @param kind ELANMOC2_RESP_KIND_TOUCH, or ELANMOC2_RESP_KIND_CAPTURE for an enroll capture
+ * @return Classification entry, never NULL
+ */
+static const struct elanmoc2_resp_class *
+elanmoc2_classify_touch (FpiDeviceElanMoC2 *self, unsigned char code, enum elanmoc2_resp_kind kind)
+{
+  const struct elanmoc2_resp_class *resp = elanmoc2_classify_response (code, kind);
 
-    case 0xff:
-      // Treat as retry - device may need more time or finger placement
-      fp_info ("Got 0xff response, treating as retry");
-      *error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_CENTER_FINGER,
-                                         "Please place your finger on the sensor");
-      return TRUE;
+  g_atomic_int_inc (&elanmoc2_stats.responses[self->stats_op][code]);
+  g_atomic_int_inc (&elanmoc2_stats.touches);
+  if (self->stats_op == ELANMOC2_OP_IDENTIFY || self->stats_op == ELANMOC2_OP_VERIFY)
+    g_atomic_int_inc (&elanmoc2_stats.touches_since_match);
+  if (resp->action == ELANMOC2_RESP_ACTION_FATAL)
+    elanmoc2_stats_op_failed (self);
 
-    default:
-      fp_info ("Unknown response code: 0x%02x", self->buffer_in[1]);
-      *error = fpi_device_error_new_msg (FP_DEVICE_ERROR_GENERAL,
-                                         "Unknown error");
-      return FALSE;
-    }
+  return resp;
 }
 
 static void
@@ -431,6 +1321,8 @@ elanmoc2_identify_verify_report (FpDevice *device, FpPrint *print, GError **erro
               if (fp_print_equal (to_match, print))
                 {
                   fp_info ("Identify: finger matches");
+                  elanmoc2_stats_match (FPI_DEVICE_ELANMOC2 (device));
+                  elanmoc2_verify_cache_store (FPI_DEVICE_ELANMOC2 (device), to_match);
                   fpi_device_identify_report (device, to_match, print, NULL);
                   return TRUE;
                 }
@@ -453,6 +1345,8 @@ elanmoc2_identify_verify_report (FpDevice *device, FpPrint *print, GError **erro
           if (fp_print_equal (to_match, print))
             {
               fp_info ("Verify: finger matches");
+              elanmoc2_stats_match (FPI_DEVICE_ELANMOC2 (device));
+              elanmoc2_verify_cache_store (FPI_DEVICE_ELANMOC2 (device), to_match);
               result = FPI_MATCH_SUCCESS;
             }
           else
@@ -466,6 +1360,90 @@ elanmoc2_identify_verify_report (FpDevice *device, FpPrint *print, GError **erro
     }
 }
 
+static gboolean
+elanmoc2_identify_abort_timeout_cb (gpointer user_data)
+{
+  FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (user_data);
+
+  self->identify_abort_source = 0;
+  fp_warn ("Sensor did not answer the finger wait after abort, cancelling it");
+  g_cancellable_cancel (self->wait_cancellable);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+elanmoc2_identify_abort_cb (FpiDeviceElanMoC2 *self, GError *error)
+{
+  if (error)
+    {
+      fp_warn ("Could not abort the finger wait, cancelling it: %s", error->message);
+      g_error_free (error);
+      g_cancellable_cancel (self->wait_cancellable);
+      return;
+    }
+
+  // The sensor should now answer the pending wait; end it ourselves if it doesn't
+  self->identify_abort_source = g_timeout_add (ELANMOC2_ABORT_ANSWER_TIMEOUT, elanmoc2_identify_abort_timeout_cb,
+                                               self);
+}
+
+static void
+elanmoc2_fw_version_cb (FpiDeviceElanMoC2 *self, GError *error)
+{
+  if (error)
+    {
+      fp_warn ("Could not read the firmware version: %s", error->message);
+      g_error_free (error);
+      self->fw_version = 0;  // Not asked again
+      return;
+    }
+
+  self->fw_version = self->quick_buffer_in[1];
+  fp_info ("Firmware version: %02x (queried while armed)", self->fw_version);
+}
+
+static void
+elanmoc2_identify_quick_done_cb (FpiDeviceElanMoC2 *self, GError *error)
+{
+  fpi_ssm_next_state (self->ssm);
+}
+
+static void
+elanmoc2_identify_finger_info_cb (FpiDeviceElanMoC2 *self, GError *error)
+{
+  if (error)
+    return fpi_ssm_mark_failed (g_steal_pointer (&self->ssm), error);
+
+  // Same buffer as a response received by the state machine, sized for the whole finger info
+  self->buffer_in = g_malloc0 (cmd_finger_info.in_len + 1);
+  memcpy (self->buffer_in, self->quick_buffer_in, MIN (self->quick_buffer_in_len, cmd_finger_info.in_len));
+  self->buffer_in_len = self->quick_buffer_in_len;
+  fpi_ssm_next_state (self->ssm);
+}
+
+static void
+elanmoc2_identify_enrolled_count_cb (FpiDeviceElanMoC2 *self, GError *error)
+{
+  g_autofree uint8_t *buffer_out = NULL;
+
+  if (error)
+    {
+      fp_warn ("Could not count enrolled fingers: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self->enrolled_num = self->quick_buffer_in[1];
+  fp_info ("Identify: %d fingers enrolled (queried while armed)", self->enrolled_num);
+  if (self->enrolled_num > 0 || (buffer_out = elanmoc2_prepare_cmd (self, &cmd_abort)) == NULL)
+    return;
+
+  // Nothing can match: abort the finger wait, the sensor then answers it and the operation ends without a touch
+  fp_info ("Identify: sensor is empty, ending the finger wait");
+  self->identify_empty = TRUE;
+  elanmoc2_quick_query (self, &cmd_abort, g_steal_pointer (&buffer_out), elanmoc2_identify_abort_cb);
+}
+
 static void
 elanmoc2_identify_run_state (FpiSsm *ssm, FpDevice *device)
 {
@@ -475,50 +1453,6 @@ elanmoc2_identify_run_state (FpiSsm *ssm, FpDevice *device)
 
   switch (fpi_ssm_get_cur_state (ssm))
     {
-    case IDENTIFY_GET_NUM_ENROLLED: {
-        elanmoc2_perform_get_num_enrolled (self, ssm);
-        break;
-      }
-
-    case IDENTIFY_CHECK_NUM_ENROLLED: {
-        // Check response from GET_NUM_ENROLLED (actually this is the identify response)
-        self->enrolled_num = self->buffer_in[1];
-        fp_info ("Identify response: 0x%02x", self->buffer_in[1]);
-        
-        // Handle different response codes
-        if (self->buffer_in[1] == 0x00) {
-            // 0x00 = OK but no finger detected, keep waiting
-            fp_info ("No finger detected yet, sending another identify request");
-            fpi_ssm_jump_to_state (ssm, IDENTIFY_IDENTIFY);
-            break;
-        }
-        else if (self->buffer_in[1] == ELANMOC2_RESP_NOT_ENROLLED) {
-            // 0xfd = Not enrolled - finger detected but not in database
-            // This is what we want for enrollment!
-            fp_info ("Finger detected but NOT enrolled - ready for enrollment");
-            error = NULL;
-            elanmoc2_identify_verify_report (device, NULL, &error);
-            elanmoc2_identify_verify_complete (device, NULL);
-            fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
-            break;
-        }
-        else if (self->buffer_in[1] == ELANMOC2_RESP_MOVE_DOWN ||
-                 self->buffer_in[1] == ELANMOC2_RESP_MOVE_UP ||
-                 self->buffer_in[1] == ELANMOC2_RESP_MOVE_LEFT ||
-                 self->buffer_in[1] == ELANMOC2_RESP_MOVE_RIGHT) {
-            // Finger detected but needs repositioning
-            fp_info ("Finger needs repositioning (code 0x%02x), retrying", self->buffer_in[1]);
-            fpi_ssm_jump_to_state (ssm, IDENTIFY_IDENTIFY);
-            break;
-        }
-        else {
-            // Other response - treat as need to continue
-            fp_info ("Unknown identify response 0x%02x, continuing", self->buffer_in[1]);
-            fpi_ssm_jump_to_state (ssm, IDENTIFY_IDENTIFY);
-            break;
-        }
-      }
-
     case IDENTIFY_IDENTIFY: {
         if ((buffer_out = elanmoc2_prepare_cmd (self, &cmd_identify)) == NULL)
           {
@@ -526,28 +1460,65 @@ elanmoc2_identify_run_state (FpiSsm *ssm, FpDevice *device)
             break;
           }
         elanmoc2_cmd_transceive (device, ssm, &cmd_identify, g_steal_pointer (&buffer_out));
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_NEEDED);
+        if (self->ssm == NULL)
+          break;
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_NEEDED);
         fp_info ("Sent identification request, waiting for finger...");
+
+        // The sensor is already waiting for a touch: count the enrolled fingers meanwhile instead of before
+        if (!self->identify_armed)
+          {
+            self->identify_armed = TRUE;
+            if ((buffer_out = elanmoc2_prepare_cmd (self, &cmd_get_enrolled_count)) != NULL)
+              elanmoc2_quick_query (self, &cmd_get_enrolled_count, g_steal_pointer (&buffer_out),
+                                    elanmoc2_identify_enrolled_count_cb);
+            if (self->fw_version < 0 && (buffer_out = elanmoc2_prepare_cmd (self, &cmd_get_fw_ver)) != NULL)
+              elanmoc2_quick_query (self, &cmd_get_fw_ver, g_steal_pointer (&buffer_out), elanmoc2_fw_version_cb);
+          }
         break;
       }
 
+    case IDENTIFY_WAIT_QUICK:
+      // Quick queries still in flight go first: their responses must not reach the commands that follow
+      elanmoc2_quick_query (self, NULL, NULL, elanmoc2_identify_quick_done_cb);
+      return;  // self->buffer_in still holds the finger wait response
+
     case IDENTIFY_GET_FINGER_INFO: {
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_PRESENT);
-        error = NULL;
-        gboolean retry = elanmoc2_get_finger_error (self, &error);
-        if (error != NULL)
+        if (self->identify_empty)
           {
-            fp_info ("Identify failed: %s", error->message);
-            if (retry)
-              {
-                elanmoc2_identify_verify_report (device, NULL, &error);
-                fpi_ssm_jump_to_state (ssm, IDENTIFY_IDENTIFY);
-              }
-            else
-              {
-                elanmoc2_identify_verify_complete (device, g_steal_pointer (&error));
-                fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
-              }
+            elanmoc2_identify_verify_report (device, NULL, &error);
+            elanmoc2_identify_verify_complete (device, NULL);
+            fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
+            break;
+          }
+
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_PRESENT);
+        const struct elanmoc2_resp_class *resp = elanmoc2_classify_touch (self, self->buffer_in[1],
+                                                                          ELANMOC2_RESP_KIND_TOUCH);
+
+        if (resp->action == ELANMOC2_RESP_ACTION_RETRY)
+          {
+            fp_info ("Identify failed, retrying: %s", resp->hint);
+            error = elanmoc2_resp_retry_error (resp);
+            elanmoc2_identify_verify_report (device, NULL, &error);
+            fpi_ssm_jump_to_state (ssm, IDENTIFY_IDENTIFY);
+            break;
+          }
+        else if (resp->action == ELANMOC2_RESP_ACTION_NO_MATCH)
+          {
+            // Finger detected but not in database
+            fp_info ("Finger detected but NOT enrolled - ready for enrollment");
+            error = NULL;
+            elanmoc2_identify_verify_report (device, NULL, &error);
+            elanmoc2_identify_verify_complete (device, NULL);
+            fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
+            break;
+          }
+        else if (resp->action != ELANMOC2_RESP_ACTION_PROGRESS)
+          {
+            fp_info ("Identify failed: %s", resp->hint);
+            elanmoc2_identify_verify_complete (device, elanmoc2_resp_fatal_error (resp));
+            fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
             break;
           }
         self->print_index = self->buffer_in[1];
@@ -558,17 +1529,19 @@ elanmoc2_identify_run_state (FpiSsm *ssm, FpDevice *device)
             break;
           }
         buffer_out[3] = self->print_index;
-        elanmoc2_cmd_transceive (device, ssm, &cmd_finger_info, g_steal_pointer (&buffer_out));
+        elanmoc2_quick_query (self, &cmd_finger_info, g_steal_pointer (&buffer_out), elanmoc2_identify_finger_info_cb);
         break;
       }
 
     case IDENTIFY_CHECK_FINGER_INFO: {
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_NONE);
-
         FpPrint *print = elanmoc2_print_new_from_finger_info (self, self->print_index, self->buffer_in);
+        gboolean done;
 
         error = NULL;
-        if (elanmoc2_identify_verify_report (device, g_steal_pointer (&print), &error))
+        done = elanmoc2_identify_verify_report (device, g_steal_pointer (&print), &error);
+        // A verify mismatch loops back to waiting for a finger: go straight to NEEDED, without a NONE in between
+        elanmoc2_finger_status (self, done ? FP_FINGER_STATUS_NONE : FP_FINGER_STATUS_NEEDED);
+        if (done)
           {
             elanmoc2_identify_verify_complete (device, error);
             fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
@@ -592,8 +1565,43 @@ static void
 elanmoc2_identify_verify (FpDevice *device)
 {
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
+  FpPrint *match;
 
   fp_info ("[elanmoc2] New identify/verify operation");
+  elanmoc2_stats_op_started (self, fpi_device_get_current_action (device) == FPI_DEVICE_ACTION_IDENTIFY ?
+                            ELANMOC2_OP_IDENTIFY : ELANMOC2_OP_VERIFY);
+
+  // A fresh match for the same print answers without waking the sensor, but only once the hit is on record
+  if ((match = elanmoc2_verify_cache_lookup (self)) != NULL)
+    {
+      g_autofree gchar *detail = g_strdup_printf ("op=%s age_ms=%" G_GINT64_FORMAT,
+                                                  elanmoc2_stats_op_names[self->stats_op],
+                                                  (g_get_monotonic_time () - self->verify_cache_time) / 1000);
+
+      if (!elanmoc2_verify_cache_audit ("hit", self->verify_cache_print, detail))
+        {
+          elanmoc2_verify_cache_invalidate (self, "audit-failed");
+          match = NULL;
+        }
+    }
+  if (match != NULL)
+    {
+      // No state machine runs, so do what elanmoc2_ssm_completed_callback() would
+      self->op_serial++;
+      elanmoc2_stats_op_succeeded (self);
+      elanmoc2_stats_schedule_save (self);
+      if (self->stats_op == ELANMOC2_OP_IDENTIFY)
+        fpi_device_identify_report (device, match, g_object_ref (self->verify_cache_print), NULL);
+      else
+        fpi_device_verify_report (device, FPI_MATCH_SUCCESS, g_object_ref (self->verify_cache_print), NULL);
+      elanmoc2_identify_verify_complete (device, NULL);
+      return;
+    }
+
+  elanmoc2_pm_wake (self);
+  self->identify_armed = FALSE;
+  self->identify_empty = FALSE;
+  self->recv_jump_state = -1;
   self->ssm = fpi_ssm_new (device, elanmoc2_identify_run_state, IDENTIFY_NUM_STATES);
   fpi_ssm_start (self->ssm, elanmoc2_ssm_completed_callback);
 }
@@ -644,7 +1652,7 @@ elanmoc2_list_run_state (FpiSsm *ssm, FpDevice *device)
       break;
 
     case LIST_CHECK_FINGER_INFO:
-      fpi_device_report_finger_status (device, FP_FINGER_STATUS_NONE);
+      elanmoc2_finger_status (self, FP_FINGER_STATUS_NONE);
       fp_info ("Successfully retrieved finger info for %d", self->print_index);
 
       if (elanmoc2_finger_info_is_present (self, self->buffer_in))
@@ -674,11 +1682,42 @@ elanmoc2_list (FpDevice *device)
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
 
   fp_info ("[elanmoc2] New list operation");
+  elanmoc2_pm_wake (self);
+  elanmoc2_stats_op_started (self, ELANMOC2_OP_LIST);
+  self->recv_jump_state = -1;
   self->ssm = fpi_ssm_new (device, elanmoc2_list_run_state, LIST_NUM_STATES);
   self->list_result = g_ptr_array_new_with_free_func (g_object_unref);
   fpi_ssm_start (self->ssm, elanmoc2_list_ssm_completed_callback);
 }
 
+/**
+ * Builds and submits the enroll command for the current stage. The response is always handled by
+ * ENROLL_CHECK_ENROLLED, so this can be called from that state to pipeline the next capture.
+ * @param self FpiDeviceElanMoC2 pointer
+ * @param ssm Current state machine
+ * @return Whether the command could be built. A failed send completes the operation: callers must then check
+ *         self->ssm before reporting anything.
+ */
+static gboolean
+elanmoc2_enroll_submit_stage (FpiDeviceElanMoC2 *self, FpiSsm *ssm)
+{
+  g_autofree uint8_t *buffer_out = NULL;
+
+  if ((buffer_out = elanmoc2_prepare_cmd (self, &cmd_enroll)) == NULL)
+    return FALSE;
+
+  // Windows sends: 40 ff 01 02 08 XX 00
+  buffer_out[3] = 0x02;  // Fixed value from Windows capture (was: enrolled_num)
+  buffer_out[4] = ELANMOC2_ENROLL_TIMES;
+  buffer_out[5] = self->enroll_stage;
+  buffer_out[6] = 0;
+  self->enroll_submit_time = g_get_monotonic_time ();
+  elanmoc2_cmd_transceive_to_state (FP_DEVICE (self), ssm, &cmd_enroll, g_steal_pointer (&buffer_out),
+                                    ENROLL_CHECK_ENROLLED);
+  fp_info ("Enroll command sent: %d/%d", self->enroll_stage, ELANMOC2_ENROLL_TIMES);
+  return TRUE;
+}
+
 static void
 elanmoc2_enroll_ssm_completed_callback (FpiSsm *ssm, FpDevice *device, GError *error)
 {
@@ -737,16 +1776,19 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
             break;
           }
         elanmoc2_cmd_transceive (device, ssm, &cmd_identify, g_steal_pointer (&buffer_out));
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_NEEDED);
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_NEEDED);
         fp_info ("Sent identification request");
         break;
       }
 
     case ENROLL_GET_ENROLLED_FINGER_INFO: {
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_PRESENT);
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_PRESENT);
+
+        const struct elanmoc2_resp_class *resp = elanmoc2_classify_touch (self, self->buffer_in[1],
+                                                                          ELANMOC2_RESP_KIND_TOUCH);
 
         // Not enrolled - skip to enroll stage
-        if (self->buffer_in[1] == ELANMOC2_RESP_NOT_ENROLLED)
+        if (resp->action == ELANMOC2_RESP_ACTION_NO_MATCH)
           {
             fp_info ("Finger not enrolled, proceeding with enroll stage");
             fpi_device_enroll_progress (device, self->enroll_stage, NULL, NULL);
@@ -755,22 +1797,19 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
           }
 
         // Identification failed (i.e. dirty) - retry
-        error = NULL;
-        gboolean retry = elanmoc2_get_finger_error (self, &error);
-        if (error != NULL)
+        if (resp->action == ELANMOC2_RESP_ACTION_RETRY)
           {
-            fp_info ("Identify failed: %s", error->message);
-            if (retry)
-              {
-                fpi_device_enroll_progress (device, self->enroll_stage, NULL, error);
-                fpi_ssm_jump_to_state (ssm, ENROLL_EARLY_REENROLL_CHECK);
-              }
-            else
-              {
-                fpi_device_enroll_complete (device, NULL, g_steal_pointer (&error));
-                fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
-                self->enroll_print = NULL;
-              }
+            fp_info ("Identify failed, retrying: %s", resp->hint);
+            fpi_device_enroll_progress (device, self->enroll_stage, NULL, elanmoc2_resp_retry_error (resp));
+            fpi_ssm_jump_to_state (ssm, ENROLL_EARLY_REENROLL_CHECK);
+            break;
+          }
+        else if (resp->action == ELANMOC2_RESP_ACTION_FATAL)
+          {
+            fp_info ("Identify failed: %s", resp->hint);
+            fpi_device_enroll_complete (device, NULL, elanmoc2_resp_fatal_error (resp));
+            fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
+            self->enroll_print = NULL;
             break;
           }
 
@@ -788,7 +1827,7 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
       }
 
     case ENROLL_ATTEMPT_DELETE: {
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_NONE);
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_NONE);
         fp_info ("Deleting enrolled finger %d", self->print_index);
 
         // Attempt to delete the finger
@@ -808,7 +1847,8 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
       }
 
     case ENROLL_CHECK_DELETED: {
-        if (self->buffer_in[1] != 0)
+        if (elanmoc2_classify_response (self->buffer_in[1], ELANMOC2_RESP_KIND_COMMAND)->action !=
+            ELANMOC2_RESP_ACTION_PROGRESS)
           {
             fp_info ("Failed to delete finger %d, wiping sensor", self->print_index);
             fpi_ssm_jump_to_state (ssm, ENROLL_WIPE_SENSOR);
@@ -839,26 +1879,21 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
 
     case ENROLL_ENROLL: {
         fp_info ("DEBUG: Entering ENROLL_ENROLL state. Stage: %d", self->enroll_stage);
-        if ((buffer_out = elanmoc2_prepare_cmd (self, &cmd_enroll)) == NULL)
+        self->enroll_await_lift = FALSE;
+        if (!elanmoc2_enroll_submit_stage (self, ssm))
           {
             fp_info ("DEBUG: Failed to prepare cmd_enroll");
             fpi_ssm_next_state (ssm);
             break;
           }
-        // Windows sends: 40 ff 01 02 08 XX 00
-        buffer_out[3] = 0x02;  // Fixed value from Windows capture (was: enrolled_num)
-        buffer_out[4] = ELANMOC2_ENROLL_TIMES;
-        buffer_out[5] = self->enroll_stage;
-        buffer_out[6] = 0;
-        fp_info ("DEBUG: Calling elanmoc2_cmd_transceive for enroll");
-        elanmoc2_cmd_transceive (device, ssm, &cmd_enroll, g_steal_pointer (&buffer_out));
-        fp_info ("Enroll command sent: %d/%d", self->enroll_stage, ELANMOC2_ENROLL_TIMES);
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_NEEDED);
+        if (self->ssm == NULL)
+          break;
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_NEEDED);
         break;
       }
 
     case ENROLL_CHECK_ENROLLED: {
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_PRESENT);
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_PRESENT);
 
         fp_info ("DEBUG: ENROLL_CHECK_ENROLLED. Buffer len: %ld", self->buffer_in_len);
         if (self->buffer_in_len < 2) {
@@ -866,60 +1901,110 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
              // Force retry or fail?
         }
 
-        if (self->buffer_in[1] == 0 || self->buffer_in[1] == 3)
+        const struct elanmoc2_resp_class *resp = elanmoc2_classify_touch (self, self->buffer_in[1],
+                                                                          ELANMOC2_RESP_KIND_CAPTURE);
+
+        if (resp->action == ELANMOC2_RESP_ACTION_PROGRESS)
           {
+            gint64 capture_ms = (g_get_monotonic_time () - self->enroll_submit_time) / 1000;
+
+            // The sensor captures again right away if the finger is still resting on it after the previous stage.
+            // Don't let the same touch count twice: resubmit the stage and ask the user to lift the finger.
+            if (self->enroll_await_lift && capture_ms < ELANMOC2_FINGER_LIFT_MIN_MS)
+              {
+                gint64 now = g_get_monotonic_time ();
+
+                fp_info ("Stage %d captured after %" G_GINT64_FORMAT " ms, finger was not lifted",
+                         self->enroll_stage, capture_ms);
+                if (!elanmoc2_enroll_submit_stage (self, ssm))
+                  {
+                    fpi_ssm_jump_to_state (ssm, ENROLL_ENROLL);
+                    break;
+                  }
+                if (self->ssm == NULL)
+                  break;
+                // A resting finger is resubmitted every few hundred ms: ask to lift it once per debounce window
+                if (now - self->enroll_lift_retry_time >= ELANMOC2_FINGER_LIFT_MIN_MS * 1000)
+                  {
+                    self->enroll_lift_retry_time = now;
+                    fpi_device_enroll_progress (device, self->enroll_stage, NULL,
+                                                fpi_device_retry_new (FP_DEVICE_RETRY_REMOVE_FINGER));
+                  }
+                break;
+              }
+
             // Stage okay
-            fp_info ("Enroll stage succeeded (Code %d)", self->buffer_in[1]);
+            fp_info ("Enroll stage succeeded (Code %d) after %" G_GINT64_FORMAT " ms", self->buffer_in[1], capture_ms);
             self->enroll_stage++;
-            fpi_device_enroll_progress (device, self->enroll_stage, self->enroll_print, NULL);
             if (self->enroll_stage >= ELANMOC2_ENROLL_TIMES)
               {
+                fpi_device_enroll_progress (device, self->enroll_stage, self->enroll_print, NULL);
                 fp_info ("Enroll completed");
                 fpi_ssm_next_state (ssm);
                 break;
               }
-          }
-        else
-          {
-            // Detection error
-            error = NULL;
-            gboolean retry = elanmoc2_get_finger_error (self, &error);
-            if (error != NULL)
-              {
-                fp_info ("Enroll stage failed: %s", error->message);
-                if (self->buffer_in[1] == ELANMOC2_RESP_NOT_ENROLLED)
-                  {
-                    // Not enrolled is a fatal error for "identify" but not for "enroll"
-                    error->domain = FP_DEVICE_RETRY;
-                    error->code = FP_DEVICE_RETRY_TOO_SHORT;
-                    retry = false;
-                  }
-                if (retry)
-                  {
-                    fpi_device_enroll_progress (device, self->enroll_stage, NULL, error);
-                  }
-                else
-                  {
-                    fpi_device_enroll_complete (device, NULL, g_steal_pointer (&error));
-                    fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
-                    break;
-                  }
-              }
-            else
+
+            // Get the next capture on the wire before reporting progress
+            self->enroll_await_lift = TRUE;
+            if (!elanmoc2_enroll_submit_stage (self, ssm))
               {
-                fp_info ("Enroll stage failed for unknown reasons");
+                fpi_device_enroll_progress (device, self->enroll_stage, self->enroll_print, NULL);
+                fpi_ssm_jump_to_state (ssm, ENROLL_ENROLL);
+                break;
               }
+            if (self->ssm == NULL)
+              break;
+            fpi_device_enroll_progress (device, self->enroll_stage, self->enroll_print, NULL);
+            elanmoc2_finger_status (self, FP_FINGER_STATUS_NEEDED);
+            break;
+          }
+
+        // Detection error
+        switch (resp->action)
+          {
+          case ELANMOC2_RESP_ACTION_FATAL:
+            fp_info ("Enroll stage failed: %s", resp->hint);
+            fpi_device_enroll_complete (device, NULL, elanmoc2_resp_fatal_error (resp));
+            fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
+            break;
+
+          // Not enrolled is a fatal error for "identify" but not for "enroll"
+          case ELANMOC2_RESP_ACTION_NO_MATCH:
+          case ELANMOC2_RESP_ACTION_RETRY:
+            fp_info ("Enroll stage failed (code 0x%02x), retrying: %s", self->buffer_in[1], resp->hint);
+            error = elanmoc2_resp_retry_error (resp);
+            break;
+
+          case ELANMOC2_RESP_ACTION_PROGRESS:
+            g_assert_not_reached ();
+            break;
           }
-        
-        if (self->ssm) {
-            fp_info ("Performing another enroll");
+        if (self->ssm == NULL)
+          break;
+
+        // Resubmit the same stage first, then report the retry hint. The finger has to be placed again after a
+        // failed capture, so the next one is not a resting finger.
+        fp_info ("Performing another enroll");
+        self->enroll_await_lift = FALSE;
+        if (!elanmoc2_enroll_submit_stage (self, ssm))
+          {
+            g_clear_error (&error);
             fpi_ssm_jump_to_state (ssm, ENROLL_ENROLL);
-        }
+            break;
+          }
+        if (self->ssm == NULL)
+          {
+            g_clear_error (&error);
+            break;
+          }
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_NEEDED);
+        if (error != NULL)
+          fpi_device_enroll_progress (device, self->enroll_stage, NULL, g_steal_pointer (&error));
         break;
       }
 
     case ENROLL_LATE_REENROLL_CHECK: {
-        fpi_device_report_finger_status (device, FP_FINGER_STATUS_NONE);
+        elanmoc2_finger_status (self, FP_FINGER_STATUS_NONE);
         if ((buffer_out = elanmoc2_prepare_cmd (self, &cmd_check_enroll_collision)) == NULL)
           {
             fpi_ssm_next_state (ssm);
@@ -932,7 +2017,8 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
 
     case ENROLL_COMMIT: {
         error = NULL;
-        if (self->buffer_in[1] != 0)
+        if (elanmoc2_classify_response (self->buffer_in[1], ELANMOC2_RESP_KIND_COMMAND)->action !=
+            ELANMOC2_RESP_ACTION_PROGRESS)
           {
             fp_info ("Finger is already enrolled at position %d, cannot commit", self->buffer_in[2]);
             error = fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_DUPLICATE,
@@ -960,10 +2046,13 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
       }
 
     case ENROLL_CHECK_COMMITTED: {
+        const struct elanmoc2_resp_class *resp = elanmoc2_classify_response (self->buffer_in[1],
+                                                                             ELANMOC2_RESP_KIND_COMMAND);
+
         error = NULL;
-        if (self->buffer_in[1] != 0)
+        if (resp->action != ELANMOC2_RESP_ACTION_PROGRESS)
           {
-            fp_info ("Commit failed with error code %d", self->buffer_in[1]);
+            fp_info ("Commit failed with error code %d: %s", self->buffer_in[1], resp->hint);
             error = fpi_device_error_new_msg (FP_DEVICE_ERROR_GENERAL,
                                               "Failed to store fingerprint for unknown reasons");
             fpi_device_enroll_complete (device, NULL, error);
@@ -972,6 +2061,7 @@ elanmoc2_enroll_run_state (FpiSsm *ssm, FpDevice *device)
         else
           {
             fp_info ("Commit succeeded");
+            elanmoc2_stats_op_succeeded (self);
             fpi_device_enroll_complete (device, g_object_ref (self->enroll_print), NULL);
             fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
           }
@@ -988,10 +2078,14 @@ elanmoc2_enroll (FpDevice *device)
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
 
   fp_info ("[elanmoc2] New enroll operation");
+  elanmoc2_pm_wake (self);
+  elanmoc2_verify_cache_invalidate (self, "enroll");
+  elanmoc2_stats_op_started (self, ELANMOC2_OP_ENROLL);
 
   self->enroll_stage = 0;
   fpi_device_get_enroll_data (device, &self->enroll_print);
 
+  self->recv_jump_state = -1;
   self->ssm = fpi_ssm_new (device, elanmoc2_enroll_run_state, ENROLL_NUM_STATES);
   fpi_ssm_start (self->ssm, elanmoc2_enroll_ssm_completed_callback);
 }
@@ -1043,7 +2137,10 @@ elanmoc2_delete_run_state (FpiSsm *ssm, FpDevice *device)
         // If the finger is actually still enrolled (but i.e. we provided the wrong user ID), enroll will attempt the
         // deletion again with the device-stored user ID after the user performs an identify op with that finger to
         // re-enroll it.
-        if (self->buffer_in[1] != 0 && self->buffer_in[1] != ELANMOC2_RESP_NOT_ENROLLED)
+        const struct elanmoc2_resp_class *resp = elanmoc2_classify_response (self->buffer_in[1],
+                                                                             ELANMOC2_RESP_KIND_COMMAND);
+
+        if (resp->action != ELANMOC2_RESP_ACTION_PROGRESS && resp->action != ELANMOC2_RESP_ACTION_NO_MATCH)
           fp_info ("Delete failed with error code %d, assuming no longer enrolled", self->buffer_in[1]);
 
         fpi_ssm_mark_completed (g_steal_pointer (&self->ssm));
@@ -1062,6 +2159,10 @@ elanmoc2_delete (FpDevice *device)
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
 
   fp_info ("[elanmoc2] New delete operation");
+  elanmoc2_pm_wake (self);
+  elanmoc2_verify_cache_invalidate (self, "delete");
+  elanmoc2_stats_op_started (self, ELANMOC2_OP_DELETE);
+  self->recv_jump_state = -1;
   self->ssm = fpi_ssm_new (device, elanmoc2_delete_run_state, DELETE_NUM_STATES);
   fpi_ssm_start (self->ssm, elanmoc2_ssm_completed_callback);
 }
@@ -1118,6 +2219,10 @@ elanmoc2_clear_storage (FpDevice *device)
   FpiDeviceElanMoC2 *self = FPI_DEVICE_ELANMOC2 (device);
 
   fp_info ("[elanmoc2] New clear storage operation");
+  elanmoc2_pm_wake (self);
+  elanmoc2_verify_cache_invalidate (self, "wipe");
+  elanmoc2_stats_op_started (self, ELANMOC2_OP_CLEAR_STORAGE);
+  self->recv_jump_state = -1;
   self->ssm = fpi_ssm_new (device, elanmoc2_clear_storage_run_state, CLEAR_STORAGE_NUM_STATES);
   fpi_ssm_start (self->ssm, elanmoc2_ssm_completed_callback);
 }
@@ -1127,6 +2232,11 @@ fpi_device_elanmoc2_init (FpiDeviceElanMoC2 *self)
 {
   g_warning ("ELANMOC2 DRIVER LOADED and INITIALIZED");
   G_DEBUG_HERE ();
+
+  self->recv_jump_state = -1;
+  self->usbfs_fd = -1;
+  self->fw_version = -1;
+  g_queue_init (&self->quick_queue);
 }
 
 static const FpIdEntry elanmoc2_id_table_custom[] = {
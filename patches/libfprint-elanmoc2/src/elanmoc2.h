@@ -41,12 +41,41 @@
 #define ELANMOC2_CMD_MAX_LEN 16
 #define ELANMOC2_MAX_PRINTS 10
 
+// An enroll capture returning faster than this after the previous accepted stage means the finger was never lifted.
+// A touch reported this soon after the previous result is a bounce of the same touch, not a new one.
+#define ELANMOC2_FINGER_LIFT_MIN_MS 250
+
 // USB parameters
 #define ELANMOC2_EP_CMD_OUT (0x1 | FPI_USB_ENDPOINT_OUT)
 #define ELANMOC2_EP_CMD_IN (0x3 | FPI_USB_ENDPOINT_IN)
 #define ELANMOC2_EP_MOC_CMD_IN (0x4 | FPI_USB_ENDPOINT_IN)
 #define ELANMOC2_USB_SEND_TIMEOUT 10000
 #define ELANMOC2_USB_RECV_TIMEOUT 60000
+#define ELANMOC2_USB_QUICK_RECV_TIMEOUT 2000  // Quick commands answer at once, unlike the finger wait
+#define ELANMOC2_ABORT_ANSWER_TIMEOUT 500     // After cmd_abort, time for the sensor to answer the finger wait (ms)
+
+// fp_info() is g_debug() in libfprint and only shows with G_MESSAGES_DEBUG; fp_message() always reaches the journal
+#ifndef fp_message
+#define fp_message g_message
+#endif
+
+// Runtime power management: the sensor may autosuspend once no operation is running. power/control and the
+// autosuspend delay are set by 60-elanmoc2-autosuspend.rules.
+#define ELANMOC2_AUTOSUSPEND_ENV "ELANMOC2_AUTOSUSPEND"  // "0" disables autosuspend
+#define ELANMOC2_USB_DEVICE_MAJOR 189
+
+// Verified-presence cache (opt-in): a match answers identify/verify requests for the same print for a few seconds,
+// so chained authentications (unlock, then polkit or sudo) need a single touch. Dropped on lock, suspend, cancel,
+// enroll, delete and wipe.
+#define ELANMOC2_VERIFY_CACHE_TTL_ENV "ELANMOC2_VERIFY_CACHE_TTL_MS"  // Unset or 0 disables the cache
+#define ELANMOC2_VERIFY_CACHE_TTL_MAX_MS 10000
+#define ELANMOC2_VERIFY_CACHE_AUDIT_LOG "/var/lib/fprint/elanmoc2-verify-cache.log"  // fprintd StateDirectory
+
+// Sensor health statistics, persisted across opens as a key file
+#define ELANMOC2_STATS_FILE "/var/lib/fprint/elanmoc2-stats.ini"
+#define ELANMOC2_STATS_FILE_ENV "ELANMOC2_STATS_FILE"
+#define ELANMOC2_STATS_SAVE_DELAY_S 30  // Operations within this delay share one write, flushed on close
+#define ELANMOC2_STATS_TOUCH_WINDOW 16  // Successful identifications averaged by touches_per_identify
 
 // Response codes
 #define ELANMOC2_RESP_MOVE_DOWN 0x41
@@ -57,6 +86,11 @@
 #define ELANMOC2_RESP_SENSOR_DIRTY 0xfb
 #define ELANMOC2_RESP_NOT_ENROLLED 0xfd
 #define ELANMOC2_RESP_NOT_ENOUGH_SURFACE 0xfe
+#define ELANMOC2_RESP_PLACE_FINGER 0xff
+
+// Enroll capture status codes that accept the stage
+#define ELANMOC2_RESP_STAGE_OK 0x00
+#define ELANMOC2_RESP_STAGE_CAPTURED 0x03
 
 // Currently only one device is supported, but I'd like to future-proof this driver for any new contributions.
 #define ELANMOC2_ALL_DEV 0
@@ -160,10 +194,106 @@ static const struct elanmoc2_cmd cmd_wipe_sensor = {
 };
 
 
+// Response classification, shared by all state machines. Low status codes mean different things depending on what
+// answered: a finger index after identify, a stage status after an enroll capture, success (0) after a command.
+
+enum elanmoc2_resp_kind {
+  ELANMOC2_RESP_KIND_TOUCH,    // Finger wait (identify, re-enroll check): any low code goes on
+  ELANMOC2_RESP_KIND_CAPTURE,  // Enroll capture: only the stage codes go on
+  ELANMOC2_RESP_KIND_COMMAND,  // Command reply (delete, commit, collision check): only 0 goes on
+};
+
+enum elanmoc2_resp_action {
+  ELANMOC2_RESP_ACTION_PROGRESS,  // Regular status code, the operation can go on
+  ELANMOC2_RESP_ACTION_RETRY,     // A finger was seen but the capture is unusable, ask the user to try again
+  ELANMOC2_RESP_ACTION_NO_MATCH,  // The capture is fine but doesn't match any enrolled finger
+  ELANMOC2_RESP_ACTION_FATAL,     // The operation can't go on
+};
+
+struct elanmoc2_resp_class
+{
+  unsigned char             code;
+  enum elanmoc2_resp_action action;
+  FpDeviceRetry             retry;  // Reported for RETRY, and for NO_MATCH while enrolling
+  FpDeviceError             error;  // Reported for FATAL, and for NO_MATCH while identifying
+  const char               *hint;
+};
+
+static const struct elanmoc2_resp_class elanmoc2_resp_classes[] = {
+  {.code = ELANMOC2_RESP_MOVE_DOWN, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_CENTER_FINGER, .hint = "Move your finger slightly downwards"},
+  {.code = ELANMOC2_RESP_MOVE_RIGHT, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_CENTER_FINGER, .hint = "Move your finger slightly to the right"},
+  {.code = ELANMOC2_RESP_MOVE_UP, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_CENTER_FINGER, .hint = "Move your finger slightly upwards"},
+  {.code = ELANMOC2_RESP_MOVE_LEFT, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_CENTER_FINGER, .hint = "Move your finger slightly to the left"},
+  {.code = ELANMOC2_RESP_SENSOR_DIRTY, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_REMOVE_FINGER, .hint = "Sensor is dirty or wet"},
+  {.code = ELANMOC2_RESP_NOT_ENOUGH_SURFACE, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_REMOVE_FINGER, .hint = "Press your finger slightly harder on the sensor"},
+  // Device may need more time or finger placement
+  {.code = ELANMOC2_RESP_PLACE_FINGER, .action = ELANMOC2_RESP_ACTION_RETRY,
+   .retry = FP_DEVICE_RETRY_CENTER_FINGER, .hint = "Please place your finger on the sensor"},
+  {.code = ELANMOC2_RESP_NOT_ENROLLED, .action = ELANMOC2_RESP_ACTION_NO_MATCH,
+   .retry = FP_DEVICE_RETRY_TOO_SHORT, .error = FP_DEVICE_ERROR_DATA_NOT_FOUND, .hint = "Finger not recognized"},
+  {.code = ELANMOC2_RESP_MAX_ENROLLED_REACHED, .action = ELANMOC2_RESP_ACTION_FATAL,
+   .error = FP_DEVICE_ERROR_DATA_FULL, .hint = "Maximum number of fingers already enrolled"},
+};
+
+// Regular status codes never have the most-significant nibble set; errors do
+static const struct elanmoc2_resp_class elanmoc2_resp_progress = {
+  .action = ELANMOC2_RESP_ACTION_PROGRESS, .hint = "OK",
+};
+
+static const struct elanmoc2_resp_class elanmoc2_resp_unknown = {
+  .action = ELANMOC2_RESP_ACTION_FATAL, .error = FP_DEVICE_ERROR_GENERAL, .hint = "Unknown error",
+};
+
+static const struct elanmoc2_resp_class elanmoc2_resp_capture_rejected = {
+  .action = ELANMOC2_RESP_ACTION_RETRY, .retry = FP_DEVICE_RETRY_GENERAL, .hint = "Capture not accepted, try again",
+};
+
+static const struct elanmoc2_resp_class elanmoc2_resp_command_failed = {
+  .action = ELANMOC2_RESP_ACTION_FATAL, .error = FP_DEVICE_ERROR_GENERAL, .hint = "Command failed",
+};
+
+
+// Operations tracked by the health statistics
+
+enum elanmoc2_stats_op {
+  ELANMOC2_OP_IDENTIFY,
+  ELANMOC2_OP_VERIFY,
+  ELANMOC2_OP_ENROLL,
+  ELANMOC2_OP_LIST,
+  ELANMOC2_OP_DELETE,
+  ELANMOC2_OP_CLEAR_STORAGE,
+  ELANMOC2_OP_NUM
+};
+
+static const char * const elanmoc2_stats_op_names[ELANMOC2_OP_NUM] = {
+  [ELANMOC2_OP_IDENTIFY] = "identify",
+  [ELANMOC2_OP_VERIFY] = "verify",
+  [ELANMOC2_OP_ENROLL] = "enroll",
+  [ELANMOC2_OP_LIST] = "list",
+  [ELANMOC2_OP_DELETE] = "delete",
+  [ELANMOC2_OP_CLEAR_STORAGE] = "clear_storage",
+};
+
+// Finger presence dwell times (touch-to-result, lift-to-next-touch), in milliseconds
+struct elanmoc2_dwell
+{
+  guint  count;
+  gint64 last_ms;
+  gint64 max_ms;
+  gint64 total_ms;
+};
+
+
+// The enrolled count is queried on the quick channel once the identify command is armed
 enum identify_states {
-  IDENTIFY_GET_NUM_ENROLLED,
-  IDENTIFY_CHECK_NUM_ENROLLED,
   IDENTIFY_IDENTIFY,
+  IDENTIFY_WAIT_QUICK,
   IDENTIFY_GET_FINGER_INFO,
   IDENTIFY_CHECK_FINGER_INFO,
   IDENTIFY_NUM_STATES
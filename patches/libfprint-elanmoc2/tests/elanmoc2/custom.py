@@ -0,0 +1,63 @@
+#!/usr/bin/python3
+
+import os
+import sys
+import tempfile
+import traceback
+
+import gi
+
+gi.require_version('FPrint', '2.0')
+from gi.repository import FPrint, GLib
+
+# Exit with error on any exception, included those happening in async callbacks
+sys.excepthook = lambda *args: (traceback.print_exception(*args), sys.exit(1))
+
+# No autosuspend ioctls on the emulated device, statistics kept out of /var/lib
+os.environ['ELANMOC2_AUTOSUSPEND'] = '0'
+os.environ['ELANMOC2_STATS_FILE'] = os.path.join(tempfile.mkdtemp(), 'elanmoc2-stats.ini')
+
+ctx = GLib.main_context_default()
+
+c = FPrint.Context()
+c.enumerate()
+devices = c.get_devices()
+
+d = devices[0]
+del devices
+
+assert d.get_driver() == "elanmoc2"
+assert d.has_feature(FPrint.DeviceFeature.STORAGE)
+
+d.open_sync()
+
+print("listing - device should have one print, in slot 0")
+gallery = d.list_prints_sync()
+assert len(gallery) == 1
+
+finger_status = []
+d.connect('notify::finger-status', lambda dev, _pspec: finger_status.append(dev.get_finger_status()))
+
+# The enrolled count and the firmware version are read on EP 0x83 while the wait is armed on EP 0x84: the touch
+# answered afterwards must still be the one identify acts on, and its finger info is read on EP 0x83 too
+print("identifying - quick queries interleaved with the armed finger wait")
+match, scanned = d.identify_sync(gallery)
+assert match is not None
+assert match.equal(gallery[0])
+assert scanned.equal(gallery[0])
+assert any(status & FPrint.FingerStatusFlags.NEEDED for status in finger_status)
+assert any(status & FPrint.FingerStatusFlags.PRESENT for status in finger_status)
+
+# Empty sensor: cmd_abort on EP 0x83 ends the armed wait, identify reports no match without a touch
+print("identifying - empty sensor")
+del finger_status[:]
+match, scanned = d.identify_sync(gallery)
+assert match is None
+assert scanned is None
+assert not any(status & FPrint.FingerStatusFlags.PRESENT for status in finger_status)
+
+print("closing")
+d.close_sync()
+
+del d
+del c
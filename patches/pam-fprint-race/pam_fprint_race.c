@@ -0,0 +1,417 @@
+/*
+ * pam_fprint_race: fingerprint and password at the same time
+ *
+ * pam_fprintd runs before the password module and blocks until the sensor
+ * matches, fails or times out: someone who types a password first waits for
+ * the whole identify loop. This module claims the reader through fprintd and
+ * starts verifying in a thread while the password prompt is shown:
+ *
+ *   - password typed first: the verification is stopped (fprintd cancels the
+ *     driver action, i.e. elanmoc2_cancel) and the password is handed to the
+ *     next module as PAM_AUTHTOK (pam_unix try_first_pass);
+ *   - finger matched first: the prompt is answered with an empty line (or any
+ *     text, which is then ignored) and the module succeeds;
+ *   - empty line before any match: the verification is stopped and the module
+ *     fails, without waiting for the finger.
+ *
+ * A PAM conversation cannot be interrupted by the module, hence the Enter
+ * after a match. The winner and the time to the first credential are written
+ * to syslog and to the log file.
+ *
+ * Services in exclude= are ignored:
+ *   - hyprlock reaches system-auth through its own PAM stack but claims the
+ *     reader itself, the two would fight over it;
+ *   - sddm answers the prompt at once with the password typed in its form
+ *     (empty for a fingerprint login), which would stop the verification
+ *     before any finger: it keeps pam_fprintd in /etc/pam.d/sddm.
+ *
+ * Usage (before pam_unix in /etc/pam.d/system-auth):
+ *   auth  sufficient  pam_fprint_race.so [timeout=30] [max-tries=3] [log=/var/log/pam-fprint-race.log]
+ *                                        [exclude=hyprlock,sddm]
+ */
+
+#include <gio/gio.h>
+#include <security/pam_ext.h>
+#include <security/pam_modules.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+#define FPRINT_NAME "net.reactivated.Fprint"
+#define FPRINT_MANAGER_PATH "/net/reactivated/Fprint/Manager"
+#define FPRINT_MANAGER_IFACE "net.reactivated.Fprint.Manager"
+#define FPRINT_DEVICE_IFACE "net.reactivated.Fprint.Device"
+
+#define RACE_DEFAULT_TIMEOUT_S 30
+#define RACE_DEFAULT_MAX_TRIES 3
+#define RACE_DEFAULT_LOG "/var/log/pam-fprint-race.log"
+#define RACE_DEFAULT_EXCLUDE "hyprlock,sddm"  /* Comma-separated PAM services */
+#define RACE_DBUS_TIMEOUT_MS 5000
+#define RACE_PROMPT "Mot de passe (ou empreinte puis Entrée) : "
+
+enum race_result {
+  RACE_PENDING,
+  RACE_MATCH,
+  RACE_NO_MATCH,
+  RACE_TIMEOUT,
+  RACE_ERROR,
+  RACE_CANCELLED,
+};
+
+static const char *race_result_names[] = {
+  [RACE_PENDING] = "pending",
+  [RACE_MATCH] = "match",
+  [RACE_NO_MATCH] = "no-match",
+  [RACE_TIMEOUT] = "timeout",
+  [RACE_ERROR] = "error",
+  [RACE_CANCELLED] = "cancelled",
+};
+
+typedef struct
+{
+  pam_handle_t    *pamh;
+  GDBusConnection *bus;
+  gchar           *device;
+  const char      *user;
+  guint            timeout_s;
+  guint            max_tries;
+  guint            tries;
+
+  /* Shared between the prompt and the verify thread */
+  GMutex           lock;
+  GCond            cond;
+  enum race_result result;
+  gint64           result_us;
+
+  /* Owned by the verify thread */
+  GMainContext    *context;
+  GMainLoop       *loop;
+} Race;
+
+static gboolean
+race_quit_cb (gpointer user_data)
+{
+  Race *race = user_data;
+
+  g_main_loop_quit (race->loop);
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Records the outcome of the verification once. Returns FALSE if another
+ * outcome was recorded first (e.g. a match just before the password arrived).
+ * The quit is queued on the verify context rather than called directly: from
+ * the prompt thread, the loop may not be running yet and would miss it.
+ */
+static gboolean
+race_finish (Race *race, enum race_result result)
+{
+  gboolean first;
+
+  g_mutex_lock (&race->lock);
+  first = race->result == RACE_PENDING;
+  if (first)
+    {
+      race->result = result;
+      race->result_us = g_get_monotonic_time ();
+      g_cond_broadcast (&race->cond);
+    }
+  g_mutex_unlock (&race->lock);
+
+  if (first && race->context)
+    {
+      g_autoptr(GSource) quit = g_idle_source_new ();
+
+      g_source_set_callback (quit, race_quit_cb, race, NULL);
+      g_source_attach (quit, race->context);
+    }
+  return first;
+}
+
+static enum race_result
+race_wait (Race *race)
+{
+  enum race_result result;
+
+  g_mutex_lock (&race->lock);
+  while (race->result == RACE_PENDING)
+    g_cond_wait (&race->cond, &race->lock);
+  result = race->result;
+  g_mutex_unlock (&race->lock);
+  return result;
+}
+
+static GVariant *
+race_call (Race *race, const char *path, const char *iface, const char *method,
+           GVariant *args, GError **error)
+{
+  return g_dbus_connection_call_sync (race->bus, FPRINT_NAME, path, iface, method, args, NULL,
+                                      G_DBUS_CALL_FLAGS_NONE, RACE_DBUS_TIMEOUT_MS, NULL, error);
+}
+
+/**
+ * Finds the default reader, checks the user has enrolled prints and claims the
+ * device. Done before prompting: when the reader is busy (hyprlock verifying
+ * on its own) or unusable, the module steps aside at once.
+ */
+static gboolean
+race_open (Race *race)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *address = NULL;
+  g_autoptr(GVariant) reply = NULL;
+
+  address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+  if (address)
+    /* Private connection: the PAM client may be using the shared one */
+    race->bus = g_dbus_connection_new_for_address_sync (address,
+                                                        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                                        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                                        NULL, NULL, &error);
+  if (!race->bus)
+    goto fail;
+
+  reply = race_call (race, FPRINT_MANAGER_PATH, FPRINT_MANAGER_IFACE, "GetDefaultDevice", NULL, &error);
+  if (!reply)
+    goto fail;
+  g_variant_get (reply, "(o)", &race->device);
+  g_clear_pointer (&reply, g_variant_unref);
+
+  reply = race_call (race, race->device, FPRINT_DEVICE_IFACE, "ListEnrolledFingers",
+                     g_variant_new ("(s)", race->user), &error);
+  if (!reply)
+    goto fail;
+  g_clear_pointer (&reply, g_variant_unref);
+
+  reply = race_call (race, race->device, FPRINT_DEVICE_IFACE, "Claim",
+                     g_variant_new ("(s)", race->user), &error);
+  if (!reply)
+    goto fail;
+  return TRUE;
+
+fail:
+  pam_syslog (race->pamh, LOG_DEBUG, "fingerprint unavailable: %s", error ? error->message : "no bus");
+  return FALSE;
+}
+
+static void
+race_close (Race *race)
+{
+  g_autoptr(GVariant) reply = NULL;
+
+  if (race->device)
+    reply = race_call (race, race->device, FPRINT_DEVICE_IFACE, "Release", NULL, NULL);
+  if (race->bus)
+    g_dbus_connection_close_sync (race->bus, NULL, NULL);
+  g_clear_object (&race->bus);
+  g_clear_pointer (&race->device, g_free);
+}
+
+static gboolean
+race_verify_start (Race *race)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GVariant) reply = NULL;
+
+  race->tries++;
+  reply = race_call (race, race->device, FPRINT_DEVICE_IFACE, "VerifyStart",
+                     g_variant_new ("(s)", "any"), &error);
+  if (!reply)
+    pam_syslog (race->pamh, LOG_WARNING, "VerifyStart failed: %s", error->message);
+  return reply != NULL;
+}
+
+static void
+race_verify_stop (Race *race)
+{
+  g_autoptr(GVariant) reply = NULL;
+
+  reply = race_call (race, race->device, FPRINT_DEVICE_IFACE, "VerifyStop", NULL, NULL);
+}
+
+static void
+on_verify_status (GDBusConnection *bus, const gchar *sender, const gchar *path,
+                  const gchar *iface, const gchar *signal, GVariant *params, gpointer user_data)
+{
+  Race *race = user_data;
+  const gchar *status;
+  gboolean done;
+
+  g_variant_get (params, "(&sb)", &status, &done);
+  if (g_str_equal (status, "verify-match"))
+    {
+      race_finish (race, RACE_MATCH);
+    }
+  else if (done)
+    {
+      /* fprintd ends the verification after a no-match: start a new one */
+      race_verify_stop (race);
+      if (!g_str_equal (status, "verify-no-match"))
+        race_finish (race, RACE_ERROR);
+      else if (race->tries >= race->max_tries || !race_verify_start (race))
+        race_finish (race, RACE_NO_MATCH);
+    }
+}
+
+static gboolean
+on_verify_timeout (gpointer user_data)
+{
+  race_finish (user_data, RACE_TIMEOUT);
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+race_verify_thread (gpointer user_data)
+{
+  Race *race = user_data;
+  g_autoptr(GSource) timeout = NULL;
+  guint subscription;
+
+  g_main_context_push_thread_default (race->context);
+  subscription = g_dbus_connection_signal_subscribe (race->bus, FPRINT_NAME, FPRINT_DEVICE_IFACE,
+                                                     "VerifyStatus", race->device, NULL,
+                                                     G_DBUS_SIGNAL_FLAGS_NONE, on_verify_status, race, NULL);
+  timeout = g_timeout_source_new_seconds (race->timeout_s);
+  g_source_set_callback (timeout, on_verify_timeout, race, NULL);
+  g_source_attach (timeout, race->context);
+
+  if (race_verify_start (race))
+    {
+      /* Returns at once if the outcome was recorded already, its quit is queued */
+      g_main_loop_run (race->loop);
+      /* Match, failure or cancellation by the prompt: the driver action is stopped either way */
+      race_verify_stop (race);
+    }
+  else
+    {
+      race_finish (race, RACE_ERROR);
+    }
+
+  g_source_destroy (timeout);
+  g_dbus_connection_signal_unsubscribe (race->bus, subscription);
+  g_main_context_pop_thread_default (race->context);
+  return NULL;
+}
+
+static void
+race_log (Race *race, const char *log_path, const char *winner, gint64 elapsed_us, int ret)
+{
+  const char *service = NULL;
+  char stamp[32];
+  time_t now = time (NULL);
+  FILE *log;
+
+  pam_get_item (race->pamh, PAM_SERVICE, (const void **) &service);
+  pam_syslog (race->pamh, LOG_INFO, "user=%s winner=%s first_credential_ms=%" G_GINT64_FORMAT
+              " fingerprint=%s tries=%u", race->user, winner, elapsed_us / 1000,
+              race_result_names[race->result], race->tries);
+
+  log = fopen (log_path, "a");
+  if (!log)
+    return;
+  strftime (stamp, sizeof (stamp), "%Y-%m-%d %H:%M:%S", localtime (&now));
+  fprintf (log, "%s service=%s user=%s winner=%s first_credential_ms=%" G_GINT64_FORMAT
+           " fingerprint=%s tries=%u result=%s\n", stamp, service ? service : "?", race->user, winner,
+           elapsed_us / 1000, race_result_names[race->result], race->tries, pam_strerror (race->pamh, ret));
+  fclose (log);
+}
+
+PAM_EXTERN int
+pam_sm_authenticate (pam_handle_t *pamh, int flags, int argc, const char **argv)
+{
+  Race race = { .pamh = pamh, .timeout_s = RACE_DEFAULT_TIMEOUT_S, .max_tries = RACE_DEFAULT_MAX_TRIES };
+  const char *log_path = RACE_DEFAULT_LOG;
+  const char *exclude = RACE_DEFAULT_EXCLUDE;
+  const char *service = NULL;
+  g_auto(GStrv) excluded = NULL;
+  const char *winner = "none";
+  gint64 start_us = g_get_monotonic_time ();
+  gint64 first_us = 0;
+  gint64 typed_us;
+  char *password = NULL;
+  GThread *thread;
+  int ret;
+
+  for (int i = 0; i < argc; i++)
+    {
+      if (g_str_has_prefix (argv[i], "timeout="))
+        race.timeout_s = MAX (1, atoi (argv[i] + strlen ("timeout=")));
+      else if (g_str_has_prefix (argv[i], "max-tries="))
+        race.max_tries = MAX (1, atoi (argv[i] + strlen ("max-tries=")));
+      else if (g_str_has_prefix (argv[i], "log="))
+        log_path = argv[i] + strlen ("log=");
+      else if (g_str_has_prefix (argv[i], "exclude="))
+        exclude = argv[i] + strlen ("exclude=");
+    }
+
+  excluded = g_strsplit (exclude, ",", -1);
+  if (pam_get_item (pamh, PAM_SERVICE, (const void **) &service) == PAM_SUCCESS && service &&
+      g_strv_contains ((const gchar * const *) excluded, service))
+    return PAM_IGNORE;
+
+  if (pam_get_user (pamh, &race.user, NULL) != PAM_SUCCESS || !race.user)
+    return PAM_USER_UNKNOWN;
+
+  if (!race_open (&race))
+    {
+      race_close (&race);
+      return PAM_AUTHINFO_UNAVAIL;
+    }
+
+  g_mutex_init (&race.lock);
+  g_cond_init (&race.cond);
+  race.context = g_main_context_new ();
+  race.loop = g_main_loop_new (race.context, FALSE);
+  thread = g_thread_new ("fprint-race", race_verify_thread, &race);
+
+  ret = pam_prompt (pamh, PAM_PROMPT_ECHO_OFF, &password, "%s", RACE_PROMPT);
+  typed_us = g_get_monotonic_time ();
+
+  /* Any answer stops the sensor, unless the finger was faster: an empty line
+   * without a match fails now instead of waiting for the finger timeout */
+  race_finish (&race, RACE_CANCELLED);
+
+  if (ret == PAM_SUCCESS)
+    {
+      if (race_wait (&race) == RACE_MATCH)
+        {
+          winner = "fingerprint";
+          first_us = race.result_us;
+        }
+      else if (password && *password)
+        {
+          /* Checked by pam_unix (try_first_pass) */
+          winner = "password";
+          first_us = typed_us;
+          pam_set_item (pamh, PAM_AUTHTOK, password);
+          ret = PAM_AUTHINFO_UNAVAIL;
+        }
+      else
+        {
+          ret = PAM_AUTH_ERR;
+        }
+    }
+
+  g_thread_join (thread);
+  race_log (&race, log_path, winner, first_us ? first_us - start_us : g_get_monotonic_time () - start_us, ret);
+
+  if (password)
+    {
+      explicit_bzero (password, strlen (password));
+      free (password);
+    }
+  g_main_loop_unref (race.loop);
+  g_main_context_unref (race.context);
+  g_cond_clear (&race.cond);
+  g_mutex_clear (&race.lock);
+  race_close (&race);
+  return ret;
+}
+
+PAM_EXTERN int
+pam_sm_setcred (pam_handle_t *pamh, int flags, int argc, const char **argv)
+{
+  return PAM_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*
+ * PAM client for the pam_fprint_race test, run under pam_wrapper
+ *
+ *   pam-race-client SERVICE ANSWER DELAY_MS EXPECTED
+ *
+ * Authenticates "testuser" through libpamtest with a conversation that
+ * answers each hidden prompt with ANSWER after DELAY_MS, like someone typing
+ * (or pressing Enter after the finger). The authentication must return
+ * EXPECTED (success, auth_err, authinfo_unavail); the handle is kept to check
+ * what the module left for pam_unix. Prints, for test_pam_fprint_race.py:
+ *
+ *   prompts=<hidden prompts answered> authtok=<PAM_AUTHTOK or ->
+ */
+
+#include <libpamtest.h>
+#include <security/pam_appl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CLIENT_USER "testuser"
+
+typedef struct
+{
+  const char *answer;
+  long        delay_ms;
+  int         prompts;
+} Client;
+
+static const struct
+{
+  const char *name;
+  int         code;
+} client_results[] = {
+  { "success", PAM_SUCCESS },
+  { "auth_err", PAM_AUTH_ERR },
+  { "authinfo_unavail", PAM_AUTHINFO_UNAVAIL },
+};
+
+static int
+client_conv (int num_msg, const struct pam_message **msg, struct pam_response **resp, void *appdata_ptr)
+{
+  Client *client = appdata_ptr;
+  struct pam_response *reply = calloc (num_msg, sizeof (*reply));
+  struct timespec delay = { client->delay_ms / 1000, (client->delay_ms % 1000) * 1000000 };
+
+  if (!reply)
+    return PAM_BUF_ERR;
+
+  for (int i = 0; i < num_msg; i++)
+    {
+      switch (msg[i]->msg_style)
+        {
+        case PAM_PROMPT_ECHO_OFF:
+          client->prompts++;
+          nanosleep (&delay, NULL);
+          reply[i].resp = strdup (client->answer);
+          break;
+
+        case PAM_TEXT_INFO:
+        case PAM_ERROR_MSG:
+          fprintf (stderr, "%s\n", msg[i]->msg);
+          break;
+
+        default:
+          free (reply);
+          return PAM_CONV_ERR;
+        }
+    }
+
+  *resp = reply;
+  return PAM_SUCCESS;
+}
+
+int
+main (int argc, char **argv)
+{
+  Client client = { 0 };
+  struct pam_testcase tests[] = {
+    pam_test (PAMTEST_AUTHENTICATE, -1),
+    pam_test (PAMTEST_KEEPHANDLE, PAM_SUCCESS),
+  };
+  const struct pam_testcase *failed;
+  const char *authtok = NULL;
+  enum pamtest_err perr;
+  pam_handle_t *pamh;
+
+  if (argc != 5)
+    {
+      fprintf (stderr, "usage: %s SERVICE ANSWER DELAY_MS EXPECTED\n", argv[0]);
+      return 2;
+    }
+  client.answer = argv[2];
+  client.delay_ms = atol (argv[3]);
+
+  for (size_t i = 0; i < sizeof (client_results) / sizeof (client_results[0]); i++)
+    if (strcmp (argv[4], client_results[i].name) == 0)
+      tests[0].expected_rv = client_results[i].code;
+  if (tests[0].expected_rv < 0)
+    {
+      fprintf (stderr, "unknown result: %s\n", argv[4]);
+      return 2;
+    }
+
+  perr = run_pamtest_conv (argv[1], CLIENT_USER, client_conv, &client, tests, NULL);
+  if (perr != PAMTEST_ERR_OK)
+    {
+      failed = pamtest_failed_case (tests);
+      fprintf (stderr, "%s: %s\n", pamtest_strerror (perr),
+               failed ? pam_strerror (NULL, failed->op_rv) : "-");
+      return 1;
+    }
+
+  pamh = tests[1].case_out.ph;
+  pam_get_item (pamh, PAM_AUTHTOK, (const void **) &authtok);
+  printf ("prompts=%d authtok=%s\n", client.prompts, authtok ? authtok : "-");
+  pam_end (pamh, PAM_SUCCESS);
+  return 0;
+}
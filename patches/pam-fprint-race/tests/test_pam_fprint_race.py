@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Test de pam_fprint_race sous pam_wrapper, contre un fprintd simulé par python-dbusmock sur un bus système privé.
+Chaque cas lance pam-race-client (libpamtest), qui répond à la demande du module après un délai donné.
+
+Lancement : meson test -C <build> pam-fprint-race
+  (PAM_FPRINT_RACE_MODULE et PAM_RACE_CLIENT sont posés par meson.build)
+Dépendances : pam_wrapper, python-dbusmock
+"""
+import os
+import subprocess
+import tempfile
+import unittest
+
+try:
+    import dbus
+    import dbusmock
+except ImportError:
+    dbusmock = None
+
+FPRINT = "net.reactivated.Fprint"
+MANAGER_PATH = "/net/reactivated/Fprint/Manager"
+MANAGER = f"{FPRINT}.Manager"
+DEVICE_PATH = "/net/reactivated/Fprint/Device/0"
+DEVICE = f"{FPRINT}.Device"
+
+MODULE = os.environ.get("PAM_FPRINT_RACE_MODULE")
+CLIENT = os.environ.get("PAM_RACE_CLIENT")
+
+# Le doigt est reconnu dès VerifyStart : une réponse une seconde plus tard arrive toujours après
+FINGER_DELAY_MS = 1000
+
+
+def verify_status(status):
+    return f"self.EmitSignal('{DEVICE}', 'VerifyStatus', 'sb', ['{status}', True])"
+
+
+class PamFprintRaceTest(dbusmock.DBusTestCase if dbusmock else unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        if dbusmock is None:
+            raise unittest.SkipTest("python-dbusmock non installé")
+        if not MODULE or not CLIENT:
+            raise unittest.SkipTest("à lancer par meson test (module et client compilés)")
+        super().setUpClass()
+        cls.start_system_bus()
+        cls.dbus_con = cls.get_dbus(system_bus=True)
+
+    def setUp(self):
+        self.work = tempfile.TemporaryDirectory()
+        self.log = os.path.join(self.work.name, "race.log")
+        self.services = os.path.join(self.work.name, "pam.d")
+        os.mkdir(self.services)
+        options = f"timeout=5 max-tries=3 log={self.log}"
+        self.write_service("pam-race", f"auth sufficient {MODULE} {options}\n")
+        # Service exclu par défaut : pam_permit décide, le module doit s'effacer sans demande
+        self.write_service("sddm", f"auth sufficient {MODULE} {options}\nauth required pam_permit.so\n")
+
+        self.fprintd = self.spawn_server(FPRINT, MANAGER_PATH, MANAGER, system_bus=True, stdout=subprocess.PIPE)
+        self.manager = dbus.Interface(self.dbus_con.get_object(FPRINT, MANAGER_PATH), dbusmock.MOCK_IFACE)
+        self.manager.AddMethod(MANAGER, "GetDefaultDevice", "", "o", f"ret = '{DEVICE_PATH}'")
+
+    def tearDown(self):
+        self.fprintd.stdout.close()
+        self.fprintd.terminate()
+        self.fprintd.wait()
+        self.work.cleanup()
+
+    def write_service(self, name, content):
+        with open(os.path.join(self.services, name), "w") as service:
+            service.write(content)
+
+    def add_device(self, verify_start):
+        self.manager.AddObject(DEVICE_PATH, DEVICE, {}, [
+            ("ListEnrolledFingers", "s", "as", "ret = ['right-index-finger']"),
+            ("Claim", "s", "", ""),
+            ("Release", "", "", ""),
+            ("VerifyStart", "s", "", verify_start),
+            ("VerifyStop", "", "", ""),
+        ])
+        self.device = dbus.Interface(self.dbus_con.get_object(FPRINT, DEVICE_PATH), dbusmock.MOCK_IFACE)
+
+    def calls(self, method):
+        return len(self.device.GetMethodCalls(method))
+
+    def authenticate(self, answer, delay_ms, expected, service="pam-race"):
+        env = dict(os.environ, LD_PRELOAD="libpam_wrapper.so", PAM_WRAPPER="1",
+                   PAM_WRAPPER_SERVICE_DIR=self.services)
+        result = subprocess.run([CLIENT, service, answer, str(delay_ms), expected], env=env,
+                                capture_output=True, text=True, timeout=30)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return dict(field.split("=", 1) for field in result.stdout.split())
+
+    def log_fields(self):
+        with open(self.log) as log:
+            [line] = log.read().splitlines()
+        return dict(field.split("=", 1) for field in line.split() if "=" in field)
+
+    def test_password_first_stops_verification(self):
+        self.add_device("")
+        out = self.authenticate("secret", 0, "authinfo_unavail")
+        self.assertEqual(out, {"prompts": "1", "authtok": "secret"})
+        self.assertEqual(self.calls("VerifyStart"), 1)
+        self.assertEqual(self.calls("VerifyStop"), 1)
+        self.assertEqual(self.calls("Release"), 1)
+        fields = self.log_fields()
+        self.assertEqual(fields["winner"], "password")
+        self.assertEqual(fields["fingerprint"], "cancelled")
+
+    def test_finger_first_succeeds(self):
+        self.add_device(verify_status("verify-match"))
+        out = self.authenticate("", FINGER_DELAY_MS, "success")
+        self.assertEqual(out, {"prompts": "1", "authtok": "-"})
+        self.assertEqual(self.calls("Release"), 1)
+        fields = self.log_fields()
+        self.assertEqual(fields["winner"], "fingerprint")
+        self.assertEqual(fields["fingerprint"], "match")
+        # Temps jusqu'à la correspondance, pas jusqu'à l'Entrée
+        self.assertLess(int(fields["first_credential_ms"]), FINGER_DELAY_MS)
+
+    def test_text_after_match_is_not_a_password(self):
+        self.add_device(verify_status("verify-match"))
+        out = self.authenticate("typed-after-match", FINGER_DELAY_MS, "success")
+        self.assertEqual(out["authtok"], "-")
+
+    def test_empty_answer_without_match_fails_at_once(self):
+        self.add_device("")
+        self.authenticate("", 0, "auth_err")
+        self.assertEqual(self.calls("VerifyStop"), 1)
+        self.assertEqual(self.log_fields()["winner"], "none")
+
+    def test_no_match_retried_up_to_max_tries(self):
+        self.add_device(verify_status("verify-no-match"))
+        self.authenticate("", FINGER_DELAY_MS, "auth_err")
+        self.assertEqual(self.calls("VerifyStart"), 3)
+        fields = self.log_fields()
+        self.assertEqual(fields["fingerprint"], "no-match")
+        self.assertEqual(fields["tries"], "3")
+
+    def test_reader_busy_steps_aside_before_prompt(self):
+        self.add_device("")
+        self.device.AddMethod(DEVICE, "Claim", "s", "",
+                              f"raise dbus.exceptions.DBusException('Device was already claimed', "
+                              f"name='{FPRINT}.Error.AlreadyInUse')")
+        out = self.authenticate("unused", 0, "authinfo_unavail")
+        self.assertEqual(out["prompts"], "0")
+        self.assertEqual(self.calls("VerifyStart"), 0)
+
+    def test_sddm_excluded(self):
+        # SDDM répond à la demande tout de suite avec le mot de passe de son formulaire : il garde pam_fprintd
+        self.add_device(verify_status("verify-match"))
+        out = self.authenticate("", 0, "success", service="sddm")
+        self.assertEqual(out["prompts"], "0")
+        self.assertEqual(self.calls("Claim"), 0)
+        self.assertFalse(os.path.exists(self.log))
+
+
+if __name__ == "__main__":
+    unittest.main()
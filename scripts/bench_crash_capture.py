@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Banc de mesure : temps crash -> reprise, minidump-handler contre core complet
+  sudo scripts/bench_crash_capture.py [--sizes 256,1024] [--runs 3]
+
+Un process de test (lien "crash-bench" vers python3, pour avoir son propre nom de
+process) alloue et touche N Mio puis se tue par SIGSEGV. Le temps mesuré va du signal
+jusqu'au retour de waitpid : c'est le moment où systemd pourrait relancer le service.
+
+Modes comparés (kernel.core_pattern est restauré à la fin, même en cas d'erreur) :
+- full     : core complet écrit par le noyau dans un fichier (le coût qui gelait le CPU)
+- coredump : systemd-coredump avec Storage=external (si installé)
+- minidump : /usr/local/bin/minidump-handler (Allow=crash-bench le temps du banc)
+
+Sortie : une ligne JSON par mesure sur stdout, tableau récapitulatif sur stderr.
+"""
+import argparse
+import json
+import os
+import resource
+import shutil
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+CORE_PATTERN = "/proc/sys/kernel/core_pattern"
+CORE_PIPE_LIMIT = "/proc/sys/kernel/core_pipe_limit"
+HANDLER = "/usr/local/bin/minidump-handler"
+SYSTEMD_COREDUMP = "/usr/lib/systemd/systemd-coredump"
+MINIDUMP_DROPIN = "/run/minidump.conf.d/bench.conf"
+COREDUMP_DROPIN = "/run/systemd/coredump.conf.d/bench.conf"
+RECOVERY_TIMEOUT = 600
+
+CRASHER = """
+import os, signal, sys, time
+block = bytearray(int(sys.argv[1]) << 20)
+for i in range(0, len(block), 4096):
+    block[i] = 1
+print(time.monotonic_ns(), flush=True)
+os.kill(os.getpid(), signal.SIGSEGV)
+"""
+
+
+def write(path, value):
+    with open(path, "w") as f:
+        f.write(value)
+
+
+def read(path):
+    with open(path) as f:
+        return f.read().strip()
+
+
+def crash_once(crasher, size_mb):
+    """Temps (ms) entre le SIGSEGV et la fin du process"""
+    proc = subprocess.Popen([crasher, "-c", CRASHER, str(size_mb)], stdout=subprocess.PIPE, text=True,
+                            preexec_fn=lambda: resource.setrlimit(resource.RLIMIT_CORE,
+                                                                  (resource.RLIM_INFINITY, resource.RLIM_INFINITY)))
+    crashed_ns = int(proc.stdout.readline())
+    proc.wait(timeout=RECOVERY_TIMEOUT)
+    recovered_ns = time.monotonic_ns()
+    if proc.returncode != -signal.SIGSEGV:
+        raise RuntimeError(f"crash-bench a terminé avec le code {proc.returncode}")
+    return (recovered_ns - crashed_ns) / 1e6
+
+
+def dir_size(path):
+    return sum(os.path.getsize(os.path.join(root, name)) for root, _d, files in os.walk(path) for name in files)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--sizes", default="256,1024", help="Mémoire du process de test (Mio, séparées par ,)")
+    parser.add_argument("--runs", type=int, default=3)
+    args = parser.parse_args()
+    if os.geteuid() != 0:
+        print("Le banc modifie kernel.core_pattern : lancer avec sudo", file=sys.stderr)
+        return 1
+
+    work = tempfile.mkdtemp(prefix="crash-bench.")
+    crasher = os.path.join(work, "crash-bench")
+    os.symlink(sys.executable, crasher)
+    full_dir, mini_dir = os.path.join(work, "full"), os.path.join(work, "minidump")
+    os.makedirs(full_dir)
+
+    modes = {"full": os.path.join(full_dir, "core.%e.%p")}
+    if os.path.exists(SYSTEMD_COREDUMP):
+        modes["coredump"] = f"|{SYSTEMD_COREDUMP} %P %u %g %s %t %c %h"
+    if os.path.exists(HANDLER):
+        modes["minidump"] = f"|{HANDLER} %P %s %t %e"
+    else:
+        print(f"{HANDLER} absent (scripts/optimize_system.sh), mode minidump ignoré", file=sys.stderr)
+
+    saved_pattern, saved_limit = read(CORE_PATTERN), read(CORE_PIPE_LIMIT)
+    os.makedirs(os.path.dirname(MINIDUMP_DROPIN), exist_ok=True)
+    write(MINIDUMP_DROPIN, f"[Minidump]\nAllow=crash-bench\nMaxPerHour=0\nDirectory={mini_dir}\n")
+    os.makedirs(os.path.dirname(COREDUMP_DROPIN), exist_ok=True)
+    write(COREDUMP_DROPIN, "[Coredump]\nStorage=external\nProcessSizeMax=32G\nExternalSizeMax=32G\n")
+
+    results = []
+    try:
+        write(CORE_PIPE_LIMIT, "4")
+        for size_mb in (int(s) for s in args.sizes.split(",")):
+            for mode, pattern in modes.items():
+                write(CORE_PATTERN, pattern)
+                times = []
+                for _ in range(args.runs):
+                    times.append(crash_once(crasher, size_mb))
+                    time.sleep(0.5)  # Écriture différée du minidump hors mesure, comme en vrai
+                disk = dir_size(full_dir) if mode == "full" else dir_size(mini_dir) if mode == "minidump" else None
+                result = {"mode": mode, "size_mb": size_mb, "recovery_ms": round(statistics.median(times), 1),
+                          "runs": args.runs, "disk_bytes_per_crash": disk // args.runs if disk else None}
+                print(json.dumps(result), flush=True)
+                results.append(result)
+                for path in (full_dir, mini_dir):
+                    shutil.rmtree(path, ignore_errors=True)
+                os.makedirs(full_dir)
+    finally:
+        write(CORE_PATTERN, saved_pattern)
+        write(CORE_PIPE_LIMIT, saved_limit)
+        for path in (MINIDUMP_DROPIN, COREDUMP_DROPIN):
+            if os.path.exists(path):
+                os.unlink(path)
+        shutil.rmtree(work, ignore_errors=True)
+
+    print(f"{'mode':<10} {'Mio':>6} {'reprise (ms)':>13} {'disque/crash':>14}", file=sys.stderr)
+    for r in results:
+        disk = f"{r['disk_bytes_per_crash'] // 1024} Kio" if r["disk_bytes_per_crash"] else "-"
+        print(f"{r['mode']:<10} {r['size_mb']:>6} {r['recovery_ms']:>13.1f} {disk:>14}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Banc de mesure : démarrage du greeter SDDM avec le thème corners-custom
+  scripts/bench_sddm_greeter.py [--theme DIR] [--runs 5]
+
+Lance `sddm-greeter --test-mode` sur la plateforme Qt offscreen (pas besoin d'écran ni de
+session) et relève les marqueurs écrits par Main.qml :
+- first-frame     : première image rendue
+- password-focus  : champ mot de passe prêt à recevoir la saisie
+Les temps sont mesurés depuis le lancement du process (epoch du marqueur), et depuis le
+chargement de Main.qml.
+
+Chaque mesure est faite avec le cache des fonds (scripts/build_sddm_backgrounds.sh) puis
+sans (copie du thème sans backgrounds/cache). Sortie : une ligne JSON par mesure sur
+stdout, tableau récapitulatif sur stderr.
+"""
+import argparse
+import json
+import os
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+THEME_DIR = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                         "sddm", "themes", "corners-custom")
+GREETER = "sddm-greeter"
+MARKS = ("first-frame", "password-focus")
+MARK_RE = re.compile(r"startup (\S+) \+(\d+) ms epoch=(\d+)")
+STARTUP_TIMEOUT = 30
+
+
+def run_once(theme):
+    """Temps des marqueurs : {marqueur: (ms depuis le lancement, ms depuis Main.qml)}"""
+    env = dict(os.environ, QT_QPA_PLATFORM="offscreen", QT_LOGGING_RULES="qml.debug=true;js.debug=true")
+    launched_ms = time.time() * 1000
+    proc = subprocess.Popen([GREETER, "--test-mode", "--theme", theme], env=env, text=True,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    marks = {}
+    watchdog = threading.Timer(STARTUP_TIMEOUT, proc.kill)  # Greeter bloqué sans sortie
+    watchdog.start()
+    try:
+        for line in proc.stdout:
+            match = MARK_RE.search(line)
+            if match and match.group(1) in MARKS:
+                marks[match.group(1)] = (int(match.group(3)) - launched_ms, int(match.group(2)))
+            if len(marks) == len(MARKS):
+                break
+    finally:
+        watchdog.cancel()
+        proc.terminate()
+        try:
+            proc.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+    missing = [mark for mark in MARKS if mark not in marks]
+    if missing:
+        raise RuntimeError(f"marqueurs absents : {', '.join(missing)} (thème sans instrumentation ?)")
+    return marks
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--theme", default=THEME_DIR)
+    parser.add_argument("--runs", type=int, default=5)
+    args = parser.parse_args()
+    if not shutil.which(GREETER):
+        print(f"{GREETER} introuvable", file=sys.stderr)
+        return 1
+
+    theme = os.path.abspath(args.theme)
+    work = tempfile.mkdtemp(prefix="sddm-bench.")
+    uncached = os.path.join(work, os.path.basename(theme))
+    shutil.copytree(theme, uncached, ignore=lambda d, names: ["cache"] if d.endswith("backgrounds") else [])
+    variants = {"sans-cache": uncached}
+    if os.path.isdir(os.path.join(theme, "backgrounds", "cache")):
+        variants["cache"] = theme
+    else:
+        print("Pas de cache des fonds (scripts/build_sddm_backgrounds.sh), mesure sans cache seulement",
+              file=sys.stderr)
+
+    results = []
+    try:
+        for variant, path in variants.items():
+            runs = [run_once(path) for _ in range(args.runs)]
+            result = {"variant": variant, "runs": args.runs}
+            for mark in MARKS:
+                result[f"{mark}_ms"] = round(statistics.median(run[mark][0] for run in runs), 1)
+                result[f"{mark}_qml_ms"] = statistics.median(run[mark][1] for run in runs)
+            print(json.dumps(result), flush=True)
+            results.append(result)
+    except RuntimeError as e:
+        print(f"Erreur : {e}", file=sys.stderr)
+        return 1
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+
+    print(f"{'thème':<12} {'1re image (ms)':>15} {'focus (ms)':>11}", file=sys.stderr)
+    for r in results:
+        print(f"{r['variant']:<12} {r['first-frame_ms']:>15.1f} {r['password-focus_ms']:>11.1f}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,187 @@
+#!/bin/bash
+# Compilation incrémentale du driver elanmoc2 patché.
+#
+# Le clone de libfprint et son dossier build sont gardés en cache : après la première compilation,
+# seul elanmoc2.c est recompilé, la librairie est ré-éditée (relink) puis installée par renommage
+# atomique. Chaque phase est chronométrée.
+#
+# Usage: build_elanmoc2.sh [--update] [--no-install] [--bench] [--test]
+#   --update      Met à jour le clone de libfprint avant de compiler
+#   --no-install  Compile seulement, sans toucher à /usr/lib ni à fprintd
+#   --bench       Compile et lance aussi le benchmark CPU des fonctions du driver (sans capteur).
+#                 Résultats (JSON, une ligne par mesure) dans $CACHE_DIR/bench/<commit>.jsonl, comparés
+#                 au résultat précédent
+#   --test        Compile et lance aussi le test du driver sur capteur émulé (umockdev, tests/elanmoc2).
+#                 Active l'introspection dans le dossier build : les tests de drivers de libfprint l'utilisent
+#
+# Variables: ELANMOC2_CACHE_DIR (défaut: ~/.cache/elanmoc2)
+
+# COULEURS
+BLUE='\033[0;34m'
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m'
+
+REPO_ROOT=$(dirname $(dirname $(readlink -f $0)))
+PATCH_SRC="$REPO_ROOT/patches/libfprint-elanmoc2/src"
+BENCH_SRC="$REPO_ROOT/patches/libfprint-elanmoc2/bench"
+TEST_SRC="$REPO_ROOT/patches/libfprint-elanmoc2/tests/elanmoc2"
+CACHE_DIR="${ELANMOC2_CACHE_DIR:-${XDG_CACHE_HOME:-$HOME/.cache}/elanmoc2}"
+SRC_DIR="$CACHE_DIR/libfprint"
+BUILD_DIR="$SRC_DIR/build"
+DRIVER_DIR="$SRC_DIR/libfprint/drivers/elanmoc2"
+BENCH_DIR="$SRC_DIR/elanmoc2-bench"
+BENCH_RESULTS="$CACHE_DIR/bench"
+# Nom distinct du test elanmoc2 de libfprint (son propre enregistrement) ; le harnais prend le driver avant le "-"
+TEST_NAME="elanmoc2-quick"
+TEST_DIR="$SRC_DIR/tests/$TEST_NAME"
+LIBFPRINT_URL="https://gitlab.freedesktop.org/libfprint/libfprint.git"
+LIB_NAME="libfprint-2.so.2.0.0"
+INSTALL_DIR="/usr/lib"
+
+UPDATE=false
+INSTALL=true
+BENCH=false
+TEST=false
+for arg in "$@"; do
+    case "$arg" in
+        --update) UPDATE=true ;;
+        --no-install) INSTALL=false ;;
+        --bench) BENCH=true ;;
+        --test) TEST=true ;;
+        *) echo "Usage: $0 [--update] [--no-install] [--bench] [--test]"; exit 1 ;;
+    esac
+done
+
+die() {
+    echo -e "${RED}ERREUR: $1${NC}"
+    exit 1
+}
+
+# --- Chronométrage ---
+TIMINGS=()
+now_us() {
+    # EPOCHREALTIME utilise le séparateur décimal de la locale (point ou virgule)
+    echo "${EPOCHREALTIME/[.,]/}"
+}
+
+phase_start() {
+    PHASE_NAME="$1"
+    PHASE_T0=$(now_us)
+    echo -e "${BLUE}[$PHASE_NAME]${NC}"
+}
+
+phase_end() {
+    local elapsed_ms=$(( ($(now_us) - PHASE_T0) / 1000 ))
+    TIMINGS+=("$(printf '%-10s %8d ms' "$PHASE_NAME" "$elapsed_ms")")
+}
+
+TOTAL_T0=$(now_us)
+
+[ -d "$PATCH_SRC" ] || die "Dossier de patch non trouvé: $PATCH_SRC"
+
+# 1. SOURCES (clone unique, mise à jour sur demande)
+phase_start "sources"
+if [ ! -d "$SRC_DIR/.git" ]; then
+    echo "Clonage de libfprint dans $SRC_DIR..."
+    mkdir -p "$CACHE_DIR"
+    git clone --depth 1 "$LIBFPRINT_URL" "$SRC_DIR" || die "Clonage de libfprint impossible"
+elif [ "$UPDATE" = true ]; then
+    echo "Mise à jour de libfprint..."
+    git -C "$SRC_DIR" checkout -- libfprint/drivers/elanmoc2 meson.build tests/meson.build
+    git -C "$SRC_DIR" pull --ff-only || die "Mise à jour de libfprint impossible"
+else
+    echo "Clone en cache: $(git -C "$SRC_DIR" log -1 --format='%h %s')"
+fi
+phase_end
+
+# 2. INJECTION DU PATCH (seulement les fichiers modifiés, pour garder les dates et la compilation incrémentale)
+phase_start "patch"
+for file in elanmoc2.c elanmoc2.h; do
+    if cmp -s "$PATCH_SRC/$file" "$DRIVER_DIR/$file"; then
+        echo "$file inchangé"
+    else
+        echo "$file mis à jour"
+        cp "$PATCH_SRC/$file" "$DRIVER_DIR/$file" || die "Copie de $file impossible"
+    fi
+done
+if [ "$BENCH" = true ]; then
+    mkdir -p "$BENCH_DIR"
+    for file in elanmoc2-bench.c meson.build; do
+        cmp -s "$BENCH_SRC/$file" "$BENCH_DIR/$file" || cp "$BENCH_SRC/$file" "$BENCH_DIR/$file"
+    done
+    # Cible ajoutée à la fin du meson.build de libfprint (après libfprint/, qui définit libfprint_private_dep)
+    grep -q "subdir('elanmoc2-bench')" "$SRC_DIR/meson.build" || echo "subdir('elanmoc2-bench')" >> "$SRC_DIR/meson.build"
+fi
+if [ "$TEST" = true ]; then
+    rm -rf "$TEST_DIR"
+    cp -r "$TEST_SRC" "$TEST_DIR" || die "Copie du test impossible"
+    grep -q "'$TEST_NAME'" "$SRC_DIR/tests/meson.build" \
+        || sed -i "s/^drivers_tests = \[/&\n    '$TEST_NAME',/" "$SRC_DIR/tests/meson.build"
+fi
+phase_end
+
+# 3. CONFIGURATION (une seule fois, sans doc ni introspection qui ne sont pas installées)
+phase_start "configure"
+if [ ! -f "$BUILD_DIR/build.ninja" ]; then
+    meson setup "$BUILD_DIR" "$SRC_DIR" \
+        -Ddoc=false -Dgtk-examples=false -Dintrospection=false -Dinstalled-tests=false \
+        || die "meson setup a échoué"
+else
+    echo "Dossier build en cache"
+fi
+phase_end
+
+# 4. COMPILATION (uniquement la librairie : ninja ne recompile que les objets modifiés puis ré-édite les liens)
+phase_start "compile"
+ninja -C "$BUILD_DIR" "libfprint/$LIB_NAME" || die "Compilation échouée"
+phase_end
+
+# 4a. TEST (même harnais que les tests de drivers de libfprint : umockdev rejoue custom.ioctl, custom.py pilote libfprint)
+if [ "$TEST" = true ]; then
+    phase_start "test"
+    command -v umockdev-run > /dev/null || die "umockdev-run introuvable (paquet umockdev)"
+    if ! python3 -c 'import json, sys; sys.exit(not any(o["name"] == "introspection" and o["value"] is True
+                                                      for o in json.load(sys.stdin)))' \
+            < "$BUILD_DIR/meson-info/intro-buildoptions.json"; then
+        meson configure "$BUILD_DIR" -Dintrospection=true || die "Activation de l'introspection impossible"
+    fi
+    meson test -C "$BUILD_DIR" --print-errorlogs "$TEST_NAME" || die "Test du driver échoué"
+    phase_end
+fi
+
+# 4b. BENCHMARK (fonctions pures du driver, pour chaque profil de capteur)
+if [ "$BENCH" = true ]; then
+    phase_start "bench"
+    ninja -C "$BUILD_DIR" elanmoc2-bench/elanmoc2-bench || die "Compilation du benchmark échouée"
+    mkdir -p "$BENCH_RESULTS"
+    COMMIT=$(git -C "$REPO_ROOT" rev-parse --short HEAD 2>/dev/null || echo local)
+    git -C "$REPO_ROOT" diff --quiet HEAD -- patches/libfprint-elanmoc2 2>/dev/null || COMMIT="$COMMIT-dirty"
+    RESULT="$BENCH_RESULTS/$COMMIT.jsonl"
+    PREVIOUS=$(ls -t "$BENCH_RESULTS"/*.jsonl 2>/dev/null | grep -vx "$RESULT" | head -n 1)
+    "$BUILD_DIR/elanmoc2-bench/elanmoc2-bench" ${PREVIOUS:+--baseline "$PREVIOUS"} > "$RESULT.part" \
+        || die "Benchmark échoué"
+    mv "$RESULT.part" "$RESULT"
+    echo "Résultats: $RESULT${PREVIOUS:+ (comparés à $(basename "$PREVIOUS"))}"
+    phase_end
+fi
+
+# 5. INSTALLATION ATOMIQUE (copie à côté puis rename(2) : fprintd ne voit jamais une librairie à moitié écrite)
+if [ "$INSTALL" = true ]; then
+    phase_start "install"
+    if cmp -s "$BUILD_DIR/libfprint/$LIB_NAME" "$INSTALL_DIR/$LIB_NAME"; then
+        echo "Librairie installée déjà à jour"
+    else
+        sudo install -m 755 "$BUILD_DIR/libfprint/$LIB_NAME" "$INSTALL_DIR/.$LIB_NAME.new" \
+            || die "Copie vers $INSTALL_DIR impossible"
+        sudo mv -f "$INSTALL_DIR/.$LIB_NAME.new" "$INSTALL_DIR/$LIB_NAME" || die "Remplacement de $LIB_NAME impossible"
+        sudo systemctl restart fprintd
+        echo "Installée: $INSTALL_DIR/$LIB_NAME"
+    fi
+    phase_end
+fi
+
+# RAPPORT
+echo -e "\n${GREEN}=== TEMPS PAR PHASE ===${NC}"
+printf '%s\n' "${TIMINGS[@]}"
+printf '%-10s %8d ms\n' "total" $(( ($(now_us) - TOTAL_T0) / 1000 ))
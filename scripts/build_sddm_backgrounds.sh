@@ -0,0 +1,67 @@
+#!/bin/bash
+# Pré-calcul des fonds du thème SDDM pour chaque résolution d'écran.
+#
+# Main.qml charge backgrounds/cache/<L>x<H>/<nom>.jpg quand il existe : une image déjà à la taille
+# de la sortie (recadrée comme PreserveAspectCrop) et en JPEG, rapide à décoder, au lieu du PNG
+# d'origine (plusieurs Mo décodés puis réduits au démarrage du greeter). Sans cache, le thème
+# retombe sur BgSource.
+#
+# Usage: build_sddm_backgrounds.sh [THEME_DIR] [LxH ...]
+#   THEME_DIR  Défaut: sddm/themes/corners-custom du dépôt
+#   LxH        Résolutions en pixels physiques. Défaut: mode préféré de chaque écran
+#              branché (/sys/class/drm), sinon 1920x1080
+#
+# Dépendances: ffmpeg
+
+BLUE='\033[0;34m'
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m'
+
+REPO_ROOT=$(dirname $(dirname $(readlink -f $0)))
+THEME_DIR="$REPO_ROOT/sddm/themes/corners-custom"
+if [ -n "$1" ] && [[ ! "$1" =~ ^[0-9]+x[0-9]+$ ]]; then
+    THEME_DIR="$1"
+    shift
+fi
+JPEG_QUALITY=2  # Échelle ffmpeg -q:v, 2 = meilleure qualité utile
+
+if ! command -v ffmpeg >/dev/null; then
+    echo -e "${RED}ffmpeg introuvable${NC}"
+    exit 1
+fi
+
+SIZES=("$@")
+if [ ${#SIZES[@]} -eq 0 ]; then
+    for connector in /sys/class/drm/card*-*; do
+        [ "$(cat "$connector/status" 2>/dev/null)" = "connected" ] || continue
+        mode=$(head -n1 "$connector/modes" 2>/dev/null)
+        [ -n "$mode" ] && SIZES+=("$mode")
+    done
+    [ ${#SIZES[@]} -eq 0 ] && SIZES=("1920x1080")
+fi
+SIZES=($(printf '%s\n' "${SIZES[@]}" | sort -u))
+
+echo -e "${BLUE}Fonds SDDM : ${SIZES[*]}${NC}"
+for size in "${SIZES[@]}"; do
+    width=${size%x*}
+    height=${size#*x}
+    mkdir -p "$THEME_DIR/backgrounds/cache/$size"
+    for src in "$THEME_DIR"/backgrounds/*.{png,jpg,jpeg}; do
+        [ -f "$src" ] || continue
+        name=$(basename "${src%.*}")
+        out="$THEME_DIR/backgrounds/cache/$size/$name.jpg"
+        [ "$out" -nt "$src" ] && continue
+
+        if ffmpeg -loglevel error -y -i "$src" \
+            -vf "scale=$width:$height:force_original_aspect_ratio=increase:flags=lanczos,crop=$width:$height" \
+            -q:v $JPEG_QUALITY "$out.tmp.jpg"; then
+            mv "$out.tmp.jpg" "$out"
+            echo "  $size/$name.jpg ($(( $(stat -c %s "$src") / 1024 )) Kio -> $(( $(stat -c %s "$out") / 1024 )) Kio)"
+        else
+            rm -f "$out.tmp.jpg"
+            echo -e "${RED}Échec : $src ($size)${NC}"
+        fi
+    done
+done
+echo -e "${GREEN}Cache prêt dans $THEME_DIR/backgrounds/cache${NC}"
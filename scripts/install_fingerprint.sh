@@ -18,55 +18,73 @@ echo "Capteur $TARGET_ID détecté. Démarrage de l'installation..."
 
 # 1. DEPENDANCES
 echo "Installation des dépendances..."
-sudo pacman -S --needed base-devel meson ninja libusb glib2 systemd git python-gobject libfprint fprintd
+sudo pacman -S --needed base-devel meson ninja libusb glib2 systemd git python-gobject libfprint fprintd \
+    pam_wrapper python-dbusmock
 
-# 2. PREPARATION SOURCE
-WORK_DIR="/tmp/elan_install"
-rm -rf "$WORK_DIR"
-mkdir -p "$WORK_DIR"
-cd "$WORK_DIR"
-
-echo "Clonage du driver de base..."
-# On utilise une version connue qui fonctionne comme base
-git clone https://gitlab.freedesktop.org/libfprint/libfprint.git
-cd libfprint
-
-# 3. INJECTION DU PATCH
-echo "Injection des fichiers patchés..."
+# 2. COMPILATION ET INSTALLATION DU DRIVER
+# Le clone de libfprint est gardé en cache (~/.cache/elanmoc2) : les relances ne recompilent que le driver.
 REPO_ROOT=$(dirname $(dirname $(readlink -f $0)))
-PATCH_SRC="$REPO_ROOT/patches/libfprint-elanmoc2/src"
-
-if [ ! -d "$PATCH_SRC" ]; then
-    echo -e "${RED}ERREUR: Dossier de patch non trouvé: $PATCH_SRC${NC}"
+if ! bash "$REPO_ROOT/scripts/build_elanmoc2.sh"; then
+    echo -e "${RED}ERREUR: Compilation du driver échouée${NC}"
     exit 1
 fi
 
-cp "$PATCH_SRC/elanmoc2.c" libfprint/drivers/elanmoc2/
-cp "$PATCH_SRC/elanmoc2.h" libfprint/drivers/elanmoc2/
+# Veille USB du capteur : réglée par udev, fprintd n'a pas accès en écriture à sysfs
+sudo install -m 644 "$REPO_ROOT/system/etc/udev/rules.d/60-elanmoc2-autosuspend.rules" /etc/udev/rules.d/
+sudo udevadm control --reload
+sudo udevadm trigger --action=add --attr-match=idVendor=04f3 --subsystem-match=usb
 
-# 4. COMPILATION
-echo "Compilation..."
-meson setup build
-meson compile -C build
-
-# 5. INSTALLATION
-echo "Installation..."
-sudo cp build/libfprint/libfprint-2.so.2.0.0 /usr/lib/
-sudo systemctl restart fprintd
+# 3. MODULE PAM (empreinte et mot de passe en parallèle)
+# Testé sous pam_wrapper contre un fprintd simulé avant d'être installé : un module cassé dans system-auth
+# bloquerait sudo et la connexion.
+echo "Compilation de pam_fprint_race..."
+BUILD_DIR=$(mktemp -d)
+if ! meson setup "$BUILD_DIR" "$REPO_ROOT/patches/pam-fprint-race" > /dev/null || \
+        ! meson compile -C "$BUILD_DIR" > /dev/null; then
+    echo -e "${RED}ERREUR: Compilation de pam_fprint_race échouée${NC}"
+    rm -rf "$BUILD_DIR"
+    exit 1
+fi
+if ! meson test -C "$BUILD_DIR" --print-errorlogs pam-fprint-race; then
+    echo -e "${RED}ERREUR: Test de pam_fprint_race échoué, PAM n'est pas modifié${NC}"
+    rm -rf "$BUILD_DIR"
+    exit 1
+fi
+sudo install -m 755 "$BUILD_DIR/pam_fprint_race.so" /usr/lib/security/pam_fprint_race.so
+rm -rf "$BUILD_DIR"
 
-# 6. CONFIG PAM
+# 4. CONFIG PAM
+# pam_fprintd (bloquant, avant le mot de passe) est remplacé par pam_fprint_race : sudo et polkit lancent
+# l'empreinte pendant que le mot de passe est demandé. Le module ignore (option exclude=) :
+# - hyprlock, qui gère lui-même les deux en parallèle (hyprlock.conf) ;
+# - SDDM, qui répond à la demande dès la validation de son formulaire et arrêterait l'empreinte : il garde
+#   pam_fprintd dans /etc/pam.d/sddm, comme avant.
 echo "Configuration PAM..."
 PAM_FILE="/etc/pam.d/system-auth"
-if ! grep -q "pam_fprintd.so" "$PAM_FILE"; then
-    echo "Ajout de pam_fprintd.so à $PAM_FILE"
+if ! grep -q "pam_fprint_race.so" "$PAM_FILE"; then
+    echo "Ajout de pam_fprint_race.so à $PAM_FILE"
     # Backup
     sudo cp "$PAM_FILE" "${PAM_FILE}.bak"
-    
-    # Insertion après pam_faillock preauth
-    sudo sed -i '/auth       required                    pam_faillock.so      preauth/a auth       sufficient                  pam_fprintd.so' "$PAM_FILE"
+
+    if grep -q "pam_fprintd.so" "$PAM_FILE"; then
+        sudo sed -i 's/^\(auth[[:space:]]\+sufficient[[:space:]]\+\)pam_fprintd\.so.*/\1pam_fprint_race.so/' "$PAM_FILE"
+    else
+        # Insertion après pam_faillock preauth
+        sudo sed -i '/auth       required                    pam_faillock.so      preauth/a auth       sufficient                  pam_fprint_race.so' "$PAM_FILE"
+    fi
 else
     echo "PAM déjà configuré."
 fi
+SDDM_PAM="/etc/pam.d/sddm"
+if [ -f "$SDDM_PAM" ] && ! grep -q "pam_fprintd.so" "$SDDM_PAM"; then
+    echo "Ajout de pam_fprintd.so à $SDDM_PAM"
+    sudo cp "$SDDM_PAM" "${SDDM_PAM}.bak"
+    # Avant la première ligne auth (include system-login)
+    sudo sed -i '0,/^auth/s//auth        sufficient  pam_fprintd.so\n&/' "$SDDM_PAM"
+fi
+sudo touch /var/log/pam-fprint-race.log
+sudo chmod 600 /var/log/pam-fprint-race.log
 
 echo -e "${GREEN}=== INSTALLATION TERMINEE ===${NC}"
 echo "Testez avec: fprintd-enroll"
+echo "Statistiques: sudo cat /var/log/pam-fprint-race.log"
@@ -13,3 +13,17 @@ if [ -f "../system/etc/systemd/coredump.conf" ]; then
 else
     echo "Fichier de configuration non trouvé."
 fi
+
+# 2. Minidumps (piles des threads seulement, reste exploitable par gdb)
+# systemd-coredump reste configuré ci-dessus (Storage=none) si le handler est retiré
+echo "Installation de minidump-handler..."
+if [ -f "../system/bin/minidump-handler" ]; then
+    sudo install -Dm755 "../system/bin/minidump-handler" "/usr/local/bin/minidump-handler"
+    [ -f "/etc/minidump.conf" ] || sudo install -Dm644 "../system/etc/minidump.conf" "/etc/minidump.conf"
+    sudo install -Dm644 "../system/etc/sysctl.d/60-minidump.conf" "/etc/sysctl.d/60-minidump.conf"
+    sudo sysctl --quiet --load "/etc/sysctl.d/60-minidump.conf"
+    echo "Crashs capturés dans /var/lib/minidump (journalctl -t minidump)."
+    echo "Mesure : sudo ./bench_crash_capture.py"
+else
+    echo "minidump-handler non trouvé."
+fi
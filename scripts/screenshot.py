@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Outil de capture d'écran - Presse-papiers d'abord, disque ensuite
+Usage: screenshot.py [--level N] [region|window|full]
+  --level N   Compression zlib du fichier sauvegardé (0-9, défaut SAVE_LEVEL)
+  sans mode   Menu wofi (Rectangle / Fenêtre / Plein écran)
+
+grim (screencopy) écrit un PNG à compression rapide directement en mémoire (sortie
+standard, aucun fichier temporaire). Ce buffer est donné tout de suite à wl-copy, puis un
+thread recompresse les données d'image au niveau demandé et écrit le fichier : le
+presse-papiers n'attend plus l'encodage ni le disque.
+
+Le mode fenêtre lit la liste des clients une seule fois sur le socket IPC de Hyprland
+(pas de hyprctl ni de jq) et en tire la géométrie de la fenêtre choisie.
+
+Dépendances: grim, slurp, wl-clipboard, wofi
+"""
+import json
+import os
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+import zlib
+
+# Configuration
+SCREENSHOT_DIR = os.path.expanduser("~/Pictures/Screenshots")
+CLIPBOARD_LEVEL = 1      # Compression PNG de grim (rapide : c'est elle que le presse-papiers attend)
+SAVE_LEVEL = 6           # Compression du fichier sauvegardé (en arrière-plan)
+LOG_FILE = "/tmp/screenshot.log"
+
+MENU = {
+    " Rectangle": "region",
+    " Fenêtre": "window",
+    "🖥 Plein écran": "full",
+}
+
+HYPR_SOCKET = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/run/user/%d" % os.getuid()), "hypr",
+                           os.environ.get("HYPRLAND_INSTANCE_SIGNATURE", ""), ".socket.sock")
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
+
+
+def notify(message):
+    subprocess.Popen(["notify-send", "Capture d'écran", message])
+
+
+def hypr_request(command):
+    """Requête sur le socket IPC de Hyprland (équivalent de hyprctl, sans fork)"""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(HYPR_SOCKET)
+        sock.sendall(command.encode())
+        data = b""
+        while chunk := sock.recv(4096):
+            data += chunk
+    return data.decode()
+
+
+def wofi(options, prompt):
+    result = subprocess.run(["wofi", "-d", "-p", prompt], input="\n".join(options),
+                            capture_output=True, text=True)
+    return result.stdout.strip() if result.returncode == 0 else ""
+
+
+def png_chunk(kind, body):
+    return struct.pack(">I", len(body)) + kind + body + struct.pack(">I", zlib.crc32(kind + body))
+
+
+def recompress_png(data, level):
+    """Réécrit les chunks IDAT d'un PNG avec un autre niveau zlib (pixels inchangés)"""
+    out = [data[:8]]
+    idat = []
+    pos = 8
+    while pos < len(data):
+        length, = struct.unpack_from(">I", data, pos)
+        kind = data[pos + 4:pos + 8]
+        end = pos + 12 + length
+        if kind == b"IDAT":
+            idat.append(data[pos + 8:pos + 8 + length])
+        else:
+            if idat:
+                out.append(png_chunk(b"IDAT", zlib.compress(zlib.decompress(b"".join(idat)), level)))
+                idat = []
+            out.append(data[pos:end])
+        pos = end
+    return b"".join(out)
+
+
+def pick_region():
+    result = subprocess.run(["slurp"], capture_output=True, text=True)
+    return result.stdout.strip() if result.returncode == 0 else None
+
+
+def pick_window():
+    """Géométrie d'une fenêtre visible, à partir d'un seul instantané de la liste des clients"""
+    clients = json.loads(hypr_request("j/clients"))
+    visible = {monitor["activeWorkspace"]["id"] for monitor in json.loads(hypr_request("j/monitors"))}
+    windows = {}
+    for client in clients:
+        if client["pid"] == -1 or client.get("hidden") or client["workspace"]["id"] not in visible:
+            continue
+        geometry = f"{client['at'][0]},{client['at'][1]} {client['size'][0]}x{client['size'][1]}"
+        windows[f"{client['class']}: {client['title']}  |  {geometry}"] = geometry
+    if not windows:
+        notify("Aucune fenêtre à capturer.")
+        return None
+    choice = wofi(windows, "Choisir une fenêtre")
+    return windows.get(choice)
+
+
+def save(png, filename, level):
+    start = time.monotonic()
+    data = recompress_png(png, level) if level != CLIPBOARD_LEVEL else png
+    encoded = time.monotonic()
+    tmp = filename + ".part"
+    with open(tmp, "wb") as f:
+        f.write(data)
+    os.rename(tmp, filename)
+    log(f"Sauvegarde {os.path.basename(filename)} : {len(png) // 1024} Kio -> {len(data) // 1024} Kio "
+        f"(niveau {level}), encodage {(encoded - start) * 1000:.0f} ms, "
+        f"écriture {(time.monotonic() - encoded) * 1000:.0f} ms")
+
+
+def main():
+    args = sys.argv[1:]
+    level = SAVE_LEVEL
+    if "--level" in args:
+        i = args.index("--level")
+        level = max(0, min(9, int(args[i + 1])))
+        del args[i:i + 2]
+    mode = args[0] if args else MENU.get(wofi(MENU, "Outil de capture"))
+
+    geometry = None
+    if mode == "region":
+        geometry = pick_region()
+    elif mode == "window":
+        geometry = pick_window()
+    if mode not in ("region", "window", "full") or (mode != "full" and not geometry):
+        notify("Action annulée.")
+        return 1
+
+    # Capture en mémoire
+    start = time.monotonic()
+    cmd = ["grim", "-t", "png", "-l", str(CLIPBOARD_LEVEL)]
+    if geometry:
+        cmd += ["-g", geometry]
+    png = subprocess.run(cmd + ["-"], capture_output=True).stdout
+    captured = time.monotonic()
+    if not png:
+        notify("Échec de la capture.")
+        return 1
+
+    # Presse-papiers servi directement depuis le buffer
+    subprocess.run(["wl-copy", "-t", "image/png"], input=png)
+    copied = time.monotonic()
+    log(f"Capture {mode} : {(captured - start) * 1000:.0f} ms, presse-papiers prêt après "
+        f"{(copied - start) * 1000:.0f} ms ({len(png) // 1024} Kio)")
+
+    # Encodage et écriture disque en arrière-plan
+    os.makedirs(SCREENSHOT_DIR, exist_ok=True)
+    filename = os.path.join(SCREENSHOT_DIR, time.strftime("%Y-%m-%d_%H-%M-%S") + ".png")
+    writer = threading.Thread(target=save, args=(png, filename, level))
+    writer.start()
+    notify("Copiée dans le presse-papiers, sauvegarde en cours.")
+    writer.join()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,13 +9,47 @@ Rectangle {
 
     height: Screen.height
     width: Screen.width
+    color: config.InputColor
+
+    // Instrumentation du démarrage (journalctl -u sddm, scripts/bench_sddm_greeter.py)
+    property double startupTime: Date.now()
+    property var startupMarks: ({})
+
+    function startupMark(step) {
+        if (startupMarks[step])
+            return;
+        startupMarks[step] = true;
+        var now = Date.now();
+        console.log("startup " + step + " +" + (now - startupTime) + " ms epoch=" + now);
+    }
+
+    Connections {
+        target: root.Window.window
+        ignoreUnknownSignals: true
+
+        function onFrameSwapped() {
+            root.startupMark("first-frame");
+        }
+    }
 
     Image {
+        // Fond pré-redimensionné par scripts/build_sddm_backgrounds.sh pour cette sortie,
+        // sinon l'image d'origine (décodée à la taille de l'écran)
+        property int pixelWidth: Math.round(Screen.width * Screen.devicePixelRatio)
+        property int pixelHeight: Math.round(Screen.height * Screen.devicePixelRatio)
+
         anchors { fill: parent }
 
-        source: config.BgSource
+        source: "backgrounds/cache/" + pixelWidth + "x" + pixelHeight + "/"
+                + config.BgSource.split("/").pop().replace(/\.[^.]*$/, "") + ".jpg"
+        sourceSize: Qt.size(pixelWidth, pixelHeight)
         fillMode: Image.PreserveAspectCrop
         clip: true
+
+        onStatusChanged: {
+            if (status === Image.Error && source != Qt.resolvedUrl(config.BgSource))
+                source = config.BgSource;
+        }
     }
 
     Item {
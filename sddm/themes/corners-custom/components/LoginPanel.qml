@@ -18,7 +18,7 @@ Item {
     
     // Forcer le mode Minimal (Désactivé) par défaut au chargement
     Component.onCompleted: {
-        sessionPanel.sessionList.currentIndex = sessionMinimalIndex;
+        sessionPanel.session = sessionMinimalIndex;
     }
 
     Column {
@@ -47,9 +47,9 @@ Item {
             onClicked: {
                 // Basculer la session
                 if (automationsEnabled) {
-                    sessionPanel.sessionList.currentIndex = sessionMinimalIndex;
+                    sessionPanel.session = sessionMinimalIndex;
                 } else {
-                    sessionPanel.sessionList.currentIndex = sessionFullIndex;
+                    sessionPanel.session = sessionFullIndex;
                 }
             }
             
@@ -109,6 +109,10 @@ Item {
             height: inputHeight
             width: parent.width
             onAccepted: loginButton.clicked();
+            onActiveFocusChanged: {
+                if (activeFocus)
+                    root.startupMark("password-focus");
+            }
         }
 
         Button {
@@ -3,6 +3,8 @@ import QtQuick 2.15
 import QtQuick.Controls 2.15
 
 Item {
+    id: powerPanel
+
     implicitHeight: powerButton.height
     implicitWidth: powerButton.width
 
@@ -37,6 +39,8 @@ Item {
         hoverEnabled: true
 
         onClicked: {
+            powerPopupLoader.active = true;
+            var powerPopup = powerPopupLoader.item;
             powerPopup.visible ? powerPopup.close() : powerPopup.open();
             powerButton.state = "pressed";
         }
@@ -62,7 +66,7 @@ Item {
             },
             State {
                 name: "selection"
-                when: powerPopup.visible
+                when: powerPopupLoader.item !== null && powerPopupLoader.item.visible
 
                 PropertyChanges {
                     target: powerButtonBg
@@ -86,150 +90,158 @@ Item {
         }
     }
 
-    Popup {
-        id: powerPopup
-
-        height: inputHeight * 2.2 + padding * 2
-        x: powerButton.width + powerList.spacing
-        y: -height + powerButton.height
-        padding: 15
+    // Créé au premier clic : rien à instancier avant le premier affichage
+    Loader {
+        id: powerPopupLoader
 
-        background: Rectangle {
-            radius: config.Radius * 1.8
-            color: config.PopupColor
-        }
+        active: false
 
-        contentItem: ListView {
-            id: powerList
+        sourceComponent: Popup {
+            id: powerPopup
+            parent: powerPanel
 
-            implicitWidth: contentWidth
-            spacing: 8
-            orientation: Qt.Horizontal
-            clip: true
-            model: powerModel
+            height: inputHeight * 2.2 + padding * 2
+            x: powerButton.width + powerList.spacing
+            y: -height + powerButton.height
+            padding: 15
 
-            delegate: ItemDelegate {
-                id: powerEntry
+            background: Rectangle {
+                radius: config.Radius * 1.8
+                color: config.PopupColor
+            }
 
-                height: inputHeight * 2.2
-                width: inputHeight * 2.2
-                display: AbstractButton.TextUnderIcon
+            contentItem: ListView {
+                id: powerList
+
+                implicitWidth: contentWidth
+                spacing: 8
+                orientation: Qt.Horizontal
+                clip: true
+                model: powerModel
+
+                delegate: ItemDelegate {
+                    id: powerEntry
+
+                    height: inputHeight * 2.2
+                    width: inputHeight * 2.2
+                    display: AbstractButton.TextUnderIcon
+
+                    states: [
+                        State {
+                            name: "hovered"
+                            when: powerEntry.hovered
+
+                            PropertyChanges {
+                                target: powerEntryBg
+                                color: Qt.darker(config.PopupActiveColor, 1.2)
+                            }
+
+                            PropertyChanges {
+                                target: iconOverlay
+                                color: Qt.darker(config.PopupActiveColor, 1.2)
+                            }
+
+                            PropertyChanges {
+                                target: powerText
+                                opacity: 1
+                            }
+                        }
+                    ]
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: {
+                            powerPopup.close();
+
+                            if (index === 0) {
+                                sddm.suspend();
+                            } else if (index === 1) {
+                                sddm.reboot();
+                            } else if (index === 2) {
+                                sddm.powerOff();
+                            }
+                        }
+                    }
 
-                states: [
-                    State {
-                        name: "hovered"
-                        when: powerEntry.hovered
+                    contentItem: Item {
+                        Image {
+                            id: powerIcon
 
-                        PropertyChanges {
-                            target: powerEntryBg
-                            color: Qt.darker(config.PopupActiveColor, 1.2)
+                            anchors.centerIn: parent
+                            source: index == 0 ? Qt.resolvedUrl("../icons/sleep.svg") : (index == 1 ? Qt.resolvedUrl("../icons/restart.svg") : Qt.resolvedUrl("../icons/power.svg"))
+                            sourceSize: Qt.size(powerEntry.width * 0.5, powerEntry.height * 0.5)
                         }
 
-                        PropertyChanges {
-                            target: iconOverlay
-                            color: Qt.darker(config.PopupActiveColor, 1.2)
-                        }
+                        ColorOverlay {
+                            id: iconOverlay
 
-                        PropertyChanges {
-                            target: powerText
-                            opacity: 1
-                        }
-                    }
-                ]
-
-                MouseArea {
-                    anchors.fill: parent
-                    onClicked: {
-                        powerPopup.close();
-
-                        if (index === 0) {
-                            sddm.suspend();
-                        } else if (index === 1) {
-                            sddm.reboot();
-                        } else if (index === 2) {
-                            sddm.powerOff();
+                            anchors.fill: powerIcon
+                            source: powerIcon
+                            color: config.PopupColor
                         }
-                    }
-                }
-
-                contentItem: Item {
-                    Image {
-                        id: powerIcon
 
-                        anchors.centerIn: parent
-                        source: index == 0 ? Qt.resolvedUrl("../icons/sleep.svg") : (index == 1 ? Qt.resolvedUrl("../icons/restart.svg") : Qt.resolvedUrl("../icons/power.svg"))
-                        sourceSize: Qt.size(powerEntry.width * 0.5, powerEntry.height * 0.5)
+                        Text {
+                            id: powerText
+
+                            font {
+                                family: config.FontFamily
+                                pointSize: config.FontSize
+                                bold: true
+                            }
+
+                            anchors.centerIn: parent
+                            renderType: Text.NativeRendering
+                            horizontalAlignment: Text.AlignHCenter
+                            color: config.PopupColor
+                            text: name
+                            opacity: 0
+                        }
                     }
 
-                    ColorOverlay {
-                        id: iconOverlay
+                    background: Rectangle {
+                        id: powerEntryBg
 
-                        anchors.fill: powerIcon
-                        source: powerIcon
-                        color: config.PopupColor
+                        color: config.PopupActiveColor
+                        radius: config.Radius
                     }
 
-                    Text {
-                        id: powerText
-
-                        font {
-                            family: config.FontFamily
-                            pointSize: config.FontSize
-                            bold: true
+                    transitions: Transition {
+                        PropertyAnimation {
+                            properties: "color, opacity"
+                            duration: 150
                         }
-
-                        anchors.centerIn: parent
-                        renderType: Text.NativeRendering
-                        horizontalAlignment: Text.AlignHCenter
-                        color: config.PopupColor
-                        text: name
-                        opacity: 0
                     }
                 }
+            }
 
-                background: Rectangle {
-                    id: powerEntryBg
-
-                    color: config.PopupActiveColor
-                    radius: config.Radius
-                }
+            enter: Transition {
+                ParallelAnimation {
+                    NumberAnimation {
+                        property: "opacity"
+                        from: 0
+                        to: 1
+                        duration: 400
+                        easing.type: Easing.OutExpo
+                    }
 
-                transitions: Transition {
-                    PropertyAnimation {
-                        properties: "color, opacity"
-                        duration: 150
+                    NumberAnimation {
+                        property: "x"
+                        from: powerPopup.x - (inputWidth * 0.1)
+                        to: powerPopup.x
+                        duration: 500
+                        easing.type: Easing.OutExpo
                     }
                 }
             }
-        }
 
-        enter: Transition {
-            ParallelAnimation {
+            exit: Transition {
                 NumberAnimation {
                     property: "opacity"
-                    from: 0
-                    to: 1
-                    duration: 400
+                    from: 1
+                    to: 0
+                    duration: 300
                     easing.type: Easing.OutExpo
                 }
-
-                NumberAnimation {
-                    property: "x"
-                    from: powerPopup.x - (inputWidth * 0.1)
-                    to: powerPopup.x
-                    duration: 500
-                    easing.type: Easing.OutExpo
-                }
-            }
-        }
-
-        exit: Transition {
-            NumberAnimation {
-                property: "opacity"
-                from: 1
-                to: 0
-                duration: 300
-                easing.type: Easing.OutExpo
             }
         }
     }
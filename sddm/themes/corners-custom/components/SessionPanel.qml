@@ -3,8 +3,9 @@ import QtQuick 2.15
 import QtQuick.Controls 2.15
 
 Item {
-    property int session: sessionList.currentIndex
-    property alias sessionList: sessionList
+    id: sessionPanel
+
+    property int session: sessionModel.lastIndex
 
     implicitHeight: sessionButton.height
     implicitWidth: sessionButton.width
@@ -19,7 +20,7 @@ Item {
 
             height: inputHeight
             width: parent.width
-            highlighted: sessionList.currentIndex === index
+            highlighted: session === index
 
             states: [
                 State {
@@ -37,8 +38,8 @@ Item {
                 anchors { fill: parent }
 
                 onClicked: {
-                    sessionList.currentIndex = index;
-                    sessionPopup.close();
+                    session = index;
+                    sessionPopupLoader.item.close();
                 }
             }
 
@@ -87,6 +88,8 @@ Item {
         hoverEnabled: true
 
         onClicked: {
+            sessionPopupLoader.active = true;
+            var sessionPopup = sessionPopupLoader.item;
             sessionPopup.visible ? sessionPopup.close() : sessionPopup.open();
             sessionButton.state = "pressed";
         }
@@ -112,7 +115,7 @@ Item {
             },
             State {
                 name: "selection"
-                when: sessionPopup.visible
+                when: sessionPopupLoader.item !== null && sessionPopupLoader.item.visible
 
                 PropertyChanges {
                     target: sessionButtonBg
@@ -136,57 +139,65 @@ Item {
         }
     }
 
-    Popup {
-        id: sessionPopup
+    // Créé au premier clic : rien à instancier avant le premier affichage
+    Loader {
+        id: sessionPopupLoader
 
-        width: inputWidth + padding * 2
-        x: sessionButton.width + sessionList.spacing
-        y: -(contentHeight + padding * 2) + sessionButton.height
-        padding: 15
+        active: false
 
-        background: Rectangle {
-            radius: config.Radius * 1.8
-            color: config.PopupColor
-        }
+        sourceComponent: Popup {
+            id: sessionPopup
+            parent: sessionPanel
 
-        contentItem: ListView {
-            id: sessionList
+            width: inputWidth + padding * 2
+            x: sessionButton.width + sessionList.spacing
+            y: -(contentHeight + padding * 2) + sessionButton.height
+            padding: 15
 
-            implicitHeight: contentHeight
-            spacing: 8
-            model: sessionWrapper
-            currentIndex: sessionModel.lastIndex
-            clip: true
-        }
+            background: Rectangle {
+                radius: config.Radius * 1.8
+                color: config.PopupColor
+            }
 
-        enter: Transition {
-            ParallelAnimation {
-                NumberAnimation {
-                    property: "opacity"
-                    from: 0
-                    to: 1
-                    duration: 400
-                    easing.type: Easing.OutExpo
+            contentItem: ListView {
+                id: sessionList
+
+                implicitHeight: contentHeight
+                spacing: 8
+                model: sessionWrapper
+                currentIndex: session
+                clip: true
+            }
+
+            enter: Transition {
+                ParallelAnimation {
+                    NumberAnimation {
+                        property: "opacity"
+                        from: 0
+                        to: 1
+                        duration: 400
+                        easing.type: Easing.OutExpo
+                    }
+
+                    NumberAnimation {
+                        property: "x"
+                        from: sessionPopup.x - (inputWidth * 0.1)
+                        to: sessionPopup.x
+                        duration: 500
+                        easing.type: Easing.OutExpo
+                    }
                 }
+            }
 
+            exit: Transition {
                 NumberAnimation {
-                    property: "x"
-                    from: sessionPopup.x - (inputWidth * 0.1)
-                    to: sessionPopup.x
-                    duration: 500
+                    property: "opacity"
+                    from: 1
+                    to: 0
+                    duration: 300
                     easing.type: Easing.OutExpo
                 }
             }
         }
-
-        exit: Transition {
-            NumberAnimation {
-                property: "opacity"
-                from: 1
-                to: 0
-                duration: 300
-                easing.type: Easing.OutExpo
-            }
-        }
     }
 }
@@ -4,13 +4,16 @@ import QtQuick 2.15
 import QtQuick.Controls 2.15
 
 Column {
+    id: userPanel
+
     property var username: usernameField.text
+    property int userIndex: userModel.lastIndex
 
     spacing: 30
 
     Component.onCompleted: {
         if (userPicture.enabled) {
-            userPicture.source = userWrapper.items.get(userList.currentIndex).model.icon;
+            userPicture.source = userWrapper.items.get(userIndex).model.icon;
         }
     }
 
@@ -27,7 +30,7 @@ Column {
 
             height: inputHeight
             width: parent.width
-            highlighted: userList.currentIndex === index
+            highlighted: userIndex === index
 
             states: [
                 State {
@@ -45,10 +48,10 @@ Column {
                 anchors { fill: parent }
 
                 onClicked: {
-                    userList.currentIndex = index;
+                    userIndex = index;
                     usernameField.text = userWrapper.items.get(index).model.name;
                     userPicture.source = userWrapper.items.get(index).model.icon;
-                    userPopup.close();
+                    userPopupLoader.item.close();
                 }
             }
 
@@ -82,61 +85,72 @@ Column {
         }
     }
 
-    Popup {
-        id: userPopup
+    // Liste des utilisateurs créée au premier clic sur l'avatar
+    Loader {
+        id: userPopupLoader
+
+        active: false
+        visible: false  // Hors du Column : le popup est rattaché à userPanel
+
+        sourceComponent: Popup {
+            id: userPopup
+            parent: userPanel
         
-        enabled: config.UserPictureEnabled === "true"
+            enabled: config.UserPictureEnabled === "true"
 
-        width: inputWidth
-        padding: 15
+            width: inputWidth
+            padding: 15
 
-        background: Rectangle {
-            radius: config.Radius * 1.8
-            color: config.PopupColor
-        }
+            background: Rectangle {
+                radius: config.Radius * 1.8
+                color: config.PopupColor
+            }
 
-        contentItem: ListView {
-            id: userList
+            contentItem: ListView {
+                id: userList
 
-            implicitHeight: contentHeight
-            spacing: 8
-            model: userWrapper
-            currentIndex: userModel.lastIndex
-            clip: true
-        }
+                implicitHeight: contentHeight
+                spacing: 8
+                model: userWrapper
+                currentIndex: userIndex
+                clip: true
+            }
 
-        enter: Transition {
-            ParallelAnimation {
-                NumberAnimation {
-                    property: "opacity"
-                    from: 0
-                    to: 1
-                    duration: 400
-                    easing.type: Easing.OutExpo
+            enter: Transition {
+                ParallelAnimation {
+                    NumberAnimation {
+                        property: "opacity"
+                        from: 0
+                        to: 1
+                        duration: 400
+                        easing.type: Easing.OutExpo
+                    }
+
+                    NumberAnimation {
+                        property: "y"
+                        from: (inputWidth / 3) - userPopup.padding - (inputHeight * userList.count * 0.5) - (userList.spacing * (userList.count - 1) * 0.5) + (inputWidth * 0.1)
+                        to: (inputWidth / 3) - userPopup.padding - (inputHeight * userList.count * 0.5) - (userList.spacing * (userList.count - 1) * 0.5)
+                        duration: 500
+                        easing.type: Easing.OutExpo
+                    }
                 }
+            }
 
+            exit: Transition {
                 NumberAnimation {
-                    property: "y"
-                    from: (inputWidth / 3) - userPopup.padding - (inputHeight * userList.count * 0.5) - (userList.spacing * (userList.count - 1) * 0.5) + (inputWidth * 0.1)
-                    to: (inputWidth / 3) - userPopup.padding - (inputHeight * userList.count * 0.5) - (userList.spacing * (userList.count - 1) * 0.5)
-                    duration: 500
+                    property: "opacity"
+                    from: 1
+                    to: 0
+                    duration: 300
                     easing.type: Easing.OutExpo
                 }
             }
         }
-
-        exit: Transition {
-            NumberAnimation {
-                property: "opacity"
-                from: 1
-                to: 0
-                duration: 300
-                easing.type: Easing.OutExpo
-            }
-        }
     }
 
     Item {
+        id: pictureItem
+
         width: inputWidth
         implicitHeight: pictureBorder.height
 
@@ -188,7 +202,10 @@ Column {
 
                 anchors.fill: parent
                 hoverEnabled: true
-                onClicked: userPopup.open();
+                onClicked: {
+                    userPopupLoader.active = true;
+                    userPopupLoader.item.open();
+                }
 
                 onHoveredChanged: {
                     if (containsMouse)
@@ -225,6 +242,8 @@ Column {
             height: inputWidth / 1.5
             width: inputWidth / 1.5
             anchors.horizontalCenter: parent.horizontalCenter
+            sourceSize: Qt.size(width, height)
+            asynchronous: true
             fillMode: Image.PreserveAspectCrop
             layer.enabled: true
 
@@ -241,69 +260,77 @@ Column {
             }
         }
 
-        Popup {
-            id: incorrectPopup
+        // Créé au premier échec de connexion
+        Loader {
+            id: incorrectPopupLoader
 
-            height: incorrectText.paintedHeight * 2
-            width: inputWidth
-            y: (pictureBorder.height - height) / 2
-            onOpened: incorrectTimer.start()
+            active: false
 
-            Timer {
-                id: incorrectTimer
+            sourceComponent: Popup {
+                id: incorrectPopup
+                parent: pictureItem
 
-                interval: 3000
-                onTriggered: incorrectPopup.close()
-            }
+                height: incorrectText.paintedHeight * 2
+                width: inputWidth
+                y: (pictureBorder.height - height) / 2
+                onOpened: incorrectTimer.start()
 
-            background: Rectangle {
-                radius: config.Radius
-                color: config.PopupColor
-            }
+                Timer {
+                    id: incorrectTimer
 
-            contentItem: Text {
-                id: incorrectText
+                    interval: 3000
+                    onTriggered: incorrectPopup.close()
+                }
 
-                font {
-                    family: config.FontFamily
-                    pointSize: config.FontSize
-                    bold: true
+                background: Rectangle {
+                    radius: config.Radius
+                    color: config.PopupColor
                 }
 
-                renderType: Text.NativeRendering
-                horizontalAlignment: Text.AlignHCenter
-                verticalAlignment: Text.AlignVCenter
-                color: config.PopupActiveColor
-                text: "Incorrect username\nor password!"
-            }
+                contentItem: Text {
+                    id: incorrectText
 
-            enter: Transition {
-                ParallelAnimation {
-                    NumberAnimation {
-                        property: "opacity"
-                        from: 0
-                        to: 1
-                        duration: 400
-                        easing.type: Easing.OutExpo
+                    font {
+                        family: config.FontFamily
+                        pointSize: config.FontSize
+                        bold: true
                     }
 
-                    NumberAnimation {
-                        property: "x"
-                        from: incorrectPopup.x - (inputWidth * 0.1)
-                        to: incorrectPopup.x
-                        duration: 500
-                        easing.type: Easing.OutElastic
+                    renderType: Text.NativeRendering
+                    horizontalAlignment: Text.AlignHCenter
+                    verticalAlignment: Text.AlignVCenter
+                    color: config.PopupActiveColor
+                    text: "Incorrect username\nor password!"
+                }
+
+                enter: Transition {
+                    ParallelAnimation {
+                        NumberAnimation {
+                            property: "opacity"
+                            from: 0
+                            to: 1
+                            duration: 400
+                            easing.type: Easing.OutExpo
+                        }
+
+                        NumberAnimation {
+                            property: "x"
+                            from: incorrectPopup.x - (inputWidth * 0.1)
+                            to: incorrectPopup.x
+                            duration: 500
+                            easing.type: Easing.OutElastic
+                        }
                     }
                 }
-            }
 
-            exit: Transition {
-                NumberAnimation {
-                    property: "opacity"
-                    from: 1
-                    to: 0
-                    duration: 300
-                    easing.type: Easing.OutExpo
+                exit: Transition {
+                    NumberAnimation {
+                        property: "opacity"
+                        from: 1
+                        to: 0
+                        duration: 300
+                        easing.type: Easing.OutExpo
+                    }
                 }
             }
         }
@@ -320,7 +347,8 @@ Column {
         function onLoginSucceeded() {}
 
         function onLoginFailed() {
-            incorrectPopup.open();
+            incorrectPopupLoader.active = true;
+            incorrectPopupLoader.item.open();
         }
 
         target: sddm
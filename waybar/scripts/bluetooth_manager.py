@@ -1,115 +1,227 @@
 #!/usr/bin/env python3
-import subprocess
+"""
+Menu Bluetooth pour Waybar - BlueZ via D-Bus
+L'état de l'adaptateur et les périphériques connus sont lus en un seul appel
+(ObjectManager.GetManagedObjects, le cache de bluetoothd) : le menu s'ouvre tout de suite.
+"SCAN for devices" ouvre un menu dans lequel les périphériques découverts (signal
+InterfacesAdded) sont ajoutés au fil du scan. Aucun appel à bluetoothctl, aucun sleep.
+Connect/Pair enregistrent un agent NoInputNoOutput (org.bluez.Agent1) le temps de l'appel :
+sans agent, BlueZ refuse l'appairage ("AuthenticationFailed") si aucun autre agent ne tourne.
+"""
+import os
 import sys
 
-def run_command(command):
-    try:
-        output = subprocess.check_output(command, shell=True, stderr=subprocess.DEVNULL)
-        return output.decode('utf-8').strip()
-    except:
-        return ""
-
-def rofi_menu(options, prompt="Bluetooth"):
-    option_str = "\n".join(options)
-    command = f"echo -e '{option_str}' | rofi -dmenu -p '{prompt}' -i"
+from gi.repository import Gio, GLib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from dbus_menu import Bus, StreamMenu, log_to, notify  # noqa: E402
+
+LOG_FILE = "/tmp/waybar_bluetooth.log"
+SCAN_WINDOW = 10            # Durée du scan (secondes)
+CONNECT_TIMEOUT_MS = 30000  # Connect/Pair peuvent attendre le périphérique
+
+BLUEZ = "org.bluez"
+ADAPTER = "org.bluez.Adapter1"
+DEVICE = "org.bluez.Device1"
+OBJECT_MANAGER = "org.freedesktop.DBus.ObjectManager"
+AGENT_MANAGER = "org.bluez.AgentManager1"
+AGENT = "org.bluez.Agent1"
+AGENT_PATH = "/org/waybar/bluetooth_agent"
+AGENT_CAPABILITY = "NoInputNoOutput"  # Appairage "Just Works" : rien à saisir ni à confirmer
+AGENT_XML = f"""<node><interface name="{AGENT}">
+  <method name="Release"/>
+  <method name="RequestPinCode"><arg type="o" direction="in"/><arg type="s" direction="out"/></method>
+  <method name="DisplayPinCode"><arg type="o" direction="in"/><arg type="s" direction="in"/></method>
+  <method name="RequestPasskey"><arg type="o" direction="in"/><arg type="u" direction="out"/></method>
+  <method name="DisplayPasskey"><arg type="o" direction="in"/><arg type="u" direction="in"/>
+    <arg type="q" direction="in"/></method>
+  <method name="RequestConfirmation"><arg type="o" direction="in"/><arg type="u" direction="in"/></method>
+  <method name="RequestAuthorization"><arg type="o" direction="in"/></method>
+  <method name="AuthorizeService"><arg type="o" direction="in"/><arg type="s" direction="in"/></method>
+  <method name="Cancel"/>
+</interface></node>"""
+
+
+def log(msg):
+    log_to(LOG_FILE, msg)
+
+
+def device_info(path, props):
+    name = props.get("Alias") or props.get("Name") or props.get("Address", "?")
+    mac = props.get("Address", "?")
+    connected = bool(props.get("Connected"))
+    paired = bool(props.get("Paired"))
+    status = ""
+    if connected:
+        status = "<span color='green'>(Connected)</span>"
+    elif paired:
+        status = "<span color='blue'>(Paired)</span>"
+    return {"path": path, "mac": mac, "connected": connected, "paired": paired,
+            "display": f"{name} <span color='gray'>{mac}</span> {status}".rstrip()}
+
+
+class Agent:
+    """Agent BlueZ exporté sur la connexion de bus, enregistré pendant Connect/Pair.
+    BlueZ utilise l'agent de l'appelant pour un appairage qu'il demande : pas besoin de
+    RequestDefaultAgent (qui prendrait la place de l'agent par défaut de la session)."""
+
+    def __init__(self, bus):
+        self.bus = bus
+        info = Gio.DBusNodeInfo.new_for_xml(AGENT_XML).interfaces[0]
+        self.registration = bus.conn.register_object(AGENT_PATH, info, self.on_method_call, None, None)
+        try:
+            bus.call("/org/bluez", AGENT_MANAGER, "RegisterAgent",
+                     GLib.Variant("(os)", (AGENT_PATH, AGENT_CAPABILITY)))
+        except GLib.Error:
+            bus.conn.unregister_object(self.registration)
+            raise
+
+    def on_method_call(self, _conn, _sender, _path, _interface, method, params, invocation):
+        log(f"Agent: {method}{params.unpack()}")
+        if method in ("RequestPinCode", "RequestPasskey"):
+            # Un code à saisir ne devrait pas être demandé à un agent NoInputNoOutput
+            invocation.return_dbus_error("org.bluez.Error.Rejected", "No input available")
+        else:
+            # Confirmation/autorisation "Just Works" : c'est l'utilisateur qui a demandé l'appairage
+            invocation.return_value(None)
+
+    def unregister(self):
+        try:
+            self.bus.call("/org/bluez", AGENT_MANAGER, "UnregisterAgent", GLib.Variant("(o)", (AGENT_PATH,)))
+        except GLib.Error as e:
+            log(f"UnregisterAgent: {e.message}")
+        self.bus.conn.unregister_object(self.registration)
+
+
+class BlueZ:
+    def __init__(self):
+        self.bus = Bus(Gio.BusType.SYSTEM, BLUEZ)
+        self.adapter = None
+        self.powered = False
+        self.devices = []
+        for path, interfaces in self.bus.call("/", OBJECT_MANAGER, "GetManagedObjects")[0].items():
+            if ADAPTER in interfaces and self.adapter is None:
+                self.adapter = path
+                self.powered = bool(interfaces[ADAPTER].get("Powered"))
+            elif DEVICE in interfaces:
+                self.devices.append(device_info(path, interfaces[DEVICE]))
+        self.devices.sort(key=lambda d: (not d["connected"], not d["paired"], d["display"].lower()))
+
+    def set_powered(self, powered):
+        self.bus.set(self.adapter, ADAPTER, "Powered", GLib.Variant("b", powered))
+
+    def device_call(self, device, method):
+        self.bus.call(device["path"], DEVICE, method, timeout=CONNECT_TIMEOUT_MS)
+
+    def device_call_with_agent(self, device, method):
+        """Connect/Pair : l'agent doit pouvoir répondre à BlueZ pendant l'appel"""
+        agent = Agent(self.bus)
+        try:
+            self.bus.call_in_loop(device["path"], DEVICE, method, timeout=CONNECT_TIMEOUT_MS)
+        finally:
+            agent.unregister()
+
+    def remove(self, device):
+        self.bus.call(self.adapter, ADAPTER, "RemoveDevice", GLib.Variant("(o)", (device["path"],)))
+
+    def scan(self):
+        """Menu alimenté par la découverte ; renvoie le périphérique choisi (ou None)"""
+        found = {}
+        menu = StreamMenu([], "Scanning")
+
+        def add(path, props):
+            if not path.startswith(self.adapter + "/"):
+                return
+            device = device_info(path, props)
+            if device["display"] not in found:
+                found[device["display"]] = device
+                menu.append([device["display"]])
+
+        subscription = self.bus.subscribe(OBJECT_MANAGER, "InterfacesAdded", "/",
+                                          lambda _p, args: add(args[0], args[1][DEVICE])
+                                          if DEVICE in args[1] else None)
+        # Périphériques déjà en cache d'abord
+        for device in self.devices:
+            found[device["display"]] = device
+        menu.append(list(found))
+        try:
+            self.bus.call(self.adapter, ADAPTER, "StartDiscovery")
+        except GLib.Error as e:
+            log(f"StartDiscovery: {e.message}")
+        GLib.timeout_add_seconds(SCAN_WINDOW, lambda: menu.close_input() or GLib.SOURCE_REMOVE)
+
+        selected = menu.run()
+        self.bus.unsubscribe(subscription)
+        try:
+            self.bus.call(self.adapter, ADAPTER, "StopDiscovery")
+        except GLib.Error:
+            pass  # Déjà arrêté (menu fermé avant la fin du scan)
+        return found.get(selected) if selected else None
+
+
+def device_actions(bluez, device):
+    actions = ["Connect", "Disconnect", "Pair", "Remove/Unpair"]
+    menu = StreamMenu(actions, f"Device: {device['mac']}")
+    menu.close_input()
+    action = menu.run()
     try:
-        output = subprocess.check_output(command, shell=True)
-        return output.decode('utf-8').strip()
-    except:
-        return None
-
-def notify(title, message):
-    subprocess.run(f"notify-send '{title}' '{message}'", shell=True)
-
-def get_devices():
-    devices_output = run_command("bluetoothctl devices")
-    paired_output = run_command("bluetoothctl paired-devices")
-    
-    devices = []
-    if devices_output:
-        for line in devices_output.split('\n'):
-            parts = line.split(' ', 2)
-            if len(parts) >= 3:
-                mac = parts[1]
-                name = parts[2]
-                
-                # Simple check for connection/pairing
-                is_paired = mac in paired_output
-                info = run_command(f"bluetoothctl info {mac}")
-                is_connected = "Connected: yes" in info
-                
-                status = ""
-                if is_connected:
-                    status = "<span color='green'>(Connected)</span>"
-                elif is_paired:
-                    status = "<span color='blue'>(Paired)</span>"
-                
-                display = f"{name} <span color='gray'>{mac}</span> {status}"
-                devices.append({'display': display, 'mac': mac, 'connected': is_connected, 'paired': is_paired})
-    return devices
+        if action == "Connect":
+            notify("Bluetooth", f"Connecting to {device['mac']}")
+            bluez.device_call_with_agent(device, "Connect")
+            notify("Bluetooth", f"Connected to {device['mac']}")
+        elif action == "Disconnect":
+            bluez.device_call(device, "Disconnect")
+            notify("Bluetooth", f"Disconnected {device['mac']}")
+        elif action == "Pair":
+            notify("Bluetooth", f"Pairing with {device['mac']}")
+            bluez.device_call_with_agent(device, "Pair")
+            notify("Bluetooth", f"Paired with {device['mac']}")
+        elif action == "Remove/Unpair":
+            bluez.remove(device)
+            notify("Bluetooth", f"Removed {device['mac']}")
+    except GLib.Error as e:
+        log(f"{action} {device['mac']}: {e.message}")
+        notify("Bluetooth", f"{action} failed: {e.message}")
+
 
 def main():
-    # Simple state check
-    show_out = run_command("bluetoothctl show")
-    is_on = "Powered: yes" in show_out
-    
-    menu_options = []
-    
+    bluez = BlueZ()
+    if not bluez.adapter:
+        notify("Bluetooth", "No adapter found")
+        return
+
     # Always show basic controls as requested
-    menu_options.append("ENABLE Bluetooth")
-    menu_options.append("DISABLE Bluetooth")
-    menu_options.append("SCAN for devices")
-    
-    devices = get_devices()
+    options = ["ENABLE Bluetooth", "DISABLE Bluetooth", "SCAN for devices"]
+    devices = {device["display"]: device for device in bluez.devices}
     if devices:
-        menu_options.append("--- Devices ---")
-        for dev in devices:
-            menu_options.append(dev['display'])
-            
-    selected = rofi_menu(menu_options)
-    
+        options.append("--- Devices ---")
+        options += list(devices)
+
+    menu = StreamMenu(options, "Bluetooth")
+    menu.close_input()
+    selected = menu.run()
     if not selected:
         return
 
-    if selected == "ENABLE Bluetooth":
-        run_command("bluetoothctl power on")
-        notify("Bluetooth", "Attempting to enable...")
-    elif selected == "DISABLE Bluetooth":
-        run_command("bluetoothctl power off")
-        notify("Bluetooth", "Bluetooth disabled")
-    elif selected == "SCAN for devices":
-        notify("Bluetooth", "Scanning for 10 seconds...")
-        subprocess.Popen("bluetoothctl scan on", shell=True)
-        import time
-        time.sleep(10)
-        run_command("bluetoothctl scan off")
-        notify("Bluetooth", "Scan complete")
-    elif selected == "--- Devices ---":
-        pass
-    else:
-        # Device action
-        target_dev = None
-        for dev in devices:
-            if dev['display'] == selected:
-                target_dev = dev
-                break
-        
-        if target_dev:
-            actions = ["Connect", "Disconnect", "Pair", "Remove/Unpair"]
-            action = rofi_menu(actions, prompt=f"Device: {target_dev['mac']}")
-            
-            if action == "Connect":
-                run_command(f"bluetoothctl connect {target_dev['mac']}")
-                notify("Bluetooth", f"Connecting to {target_dev['mac']}")
-            elif action == "Disconnect":
-                run_command(f"bluetoothctl disconnect {target_dev['mac']}")
-                notify("Bluetooth", f"Disconnected {target_dev['mac']}")
-            elif action == "Pair":
-                run_command(f"bluetoothctl pair {target_dev['mac']}")
-                notify("Bluetooth", f"Pairing with {target_dev['mac']}")
-            elif action == "Remove/Unpair":
-                run_command(f"bluetoothctl remove {target_dev['mac']}")
-                notify("Bluetooth", f"Removed {target_dev['mac']}")
+    try:
+        if selected == "ENABLE Bluetooth":
+            bluez.set_powered(True)
+            notify("Bluetooth", "Bluetooth enabled")
+        elif selected == "DISABLE Bluetooth":
+            bluez.set_powered(False)
+            notify("Bluetooth", "Bluetooth disabled")
+        elif selected == "SCAN for devices":
+            if not bluez.powered:
+                bluez.set_powered(True)
+            device = bluez.scan()
+            if device:
+                device_actions(bluez, device)
+        elif selected in devices:
+            device_actions(bluez, devices[selected])
+    except GLib.Error as e:
+        log(f"{selected}: {e.message}")
+        notify("Bluetooth", f"Error: {e.message}")
+
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,134 @@
+"""
+Outils communs des menus réseau et bluetooth (network_manager.py, bluetooth_manager.py)
+- Appels D-Bus directs (Gio) au lieu de nmcli / bluetoothctl
+- Menu rofi alimenté au fil de l'eau : la liste connue s'affiche tout de suite et les
+  résultats du scan sont ajoutés pendant que le menu est ouvert (rofi -dmenu lit son
+  entrée en asynchrone)
+
+Dépendances: python-gobject, rofi
+"""
+import subprocess
+import time
+
+from gi.repository import Gio, GLib
+
+DBUS_TIMEOUT_MS = 20000
+PROPERTIES = "org.freedesktop.DBus.Properties"
+
+
+def log_to(path, msg):
+    with open(path, "a") as f:
+        f.write(f"{time.strftime('%Y-%m-%d %H:%M:%S')} - {msg}\n")
+
+
+def notify(title, message):
+    subprocess.Popen(["notify-send", title, message])
+
+
+class Bus:
+    """Appels synchrones sur un bus D-Bus (réponses dépaquetées)"""
+
+    def __init__(self, bus_type, service):
+        self.conn = Gio.bus_get_sync(bus_type, None)
+        self.service = service
+
+    def call(self, path, interface, method, args=None, timeout=DBUS_TIMEOUT_MS):
+        reply = self.conn.call_sync(self.service, path, interface, method, args, None,
+                                    Gio.DBusCallFlags.NONE, timeout, None)
+        return reply.unpack() if reply else ()
+
+    def call_in_loop(self, path, interface, method, args=None, timeout=DBUS_TIMEOUT_MS):
+        """Comme call(), mais la boucle GLib tourne pendant l'attente : les objets exportés sur
+        cette connexion (agent BlueZ...) peuvent répondre aux appels du service"""
+        def setup(done):
+            self.conn.call(self.service, path, interface, method, args, None, Gio.DBusCallFlags.NONE,
+                           timeout, None, lambda conn, result: done(result))
+        result = wait_for(setup, timeout // 1000 + 1)
+        if result is None:
+            raise GLib.Error(f"{method}: pas de réponse")
+        reply = self.conn.call_finish(result)
+        return reply.unpack() if reply else ()
+
+    def get_all(self, path, interface):
+        return self.call(path, PROPERTIES, "GetAll", GLib.Variant("(s)", (interface,)))[0]
+
+    def get(self, path, interface, name):
+        return self.call(path, PROPERTIES, "Get", GLib.Variant("(ss)", (interface, name)))[0]
+
+    def set(self, path, interface, name, value):
+        self.call(path, PROPERTIES, "Set", GLib.Variant("(ssv)", (interface, name, value)))
+
+    def subscribe(self, interface, signal, path, callback):
+        return self.conn.signal_subscribe(self.service, interface, signal, path, None,
+                                          Gio.DBusSignalFlags.NONE,
+                                          lambda _c, _s, p, _i, _n, params: callback(p, params.unpack()))
+
+    def unsubscribe(self, subscription):
+        self.conn.signal_unsubscribe(subscription)
+
+
+class StreamMenu:
+    """rofi -dmenu dont on peut compléter la liste tant qu'il est ouvert"""
+
+    def __init__(self, options, prompt):
+        self.proc = subprocess.Popen(["rofi", "-dmenu", "-p", prompt, "-i"], stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE, text=True)
+        self.selection = None
+        self.loop = GLib.MainLoop()
+        self.append(options)
+        GLib.io_add_watch(self.proc.stdout, GLib.PRIORITY_DEFAULT, GLib.IO_IN | GLib.IO_HUP, self.on_output)
+
+    def append(self, options):
+        if self.proc.stdin.closed:
+            return
+        try:
+            self.proc.stdin.write("".join(f"{option}\n" for option in options))
+            self.proc.stdin.flush()
+        except BrokenPipeError:
+            pass  # Menu déjà fermé
+
+    def close_input(self):
+        """Fin du flux : rofi arrête d'attendre de nouvelles entrées"""
+        try:
+            self.proc.stdin.close()
+        except BrokenPipeError:
+            pass
+
+    def on_output(self, _source, _condition):
+        stdout = self.proc.stdout.read()
+        if self.proc.wait() == 0:
+            self.selection = stdout.strip() or None
+        self.loop.quit()
+        return GLib.SOURCE_REMOVE
+
+    def run(self):
+        """Attend le choix (la boucle GLib traite les signaux D-Bus pendant ce temps)"""
+        self.loop.run()
+        self.close_input()
+        return self.selection
+
+
+def wait_for(setup, timeout):
+    """Boucle GLib jusqu'à ce que setup(done) appelle done(valeur), ou None après timeout secondes"""
+    loop = GLib.MainLoop()
+    state = {"value": None, "finished": False, "timer": 0}
+
+    def done(value):
+        if not state["finished"]:
+            state["value"], state["finished"] = value, True
+            loop.quit()
+
+    def on_timeout():
+        state["timer"] = 0
+        done(None)
+        return GLib.SOURCE_REMOVE
+
+    cleanup = setup(done)
+    if not state["finished"]:
+        state["timer"] = GLib.timeout_add_seconds(timeout, on_timeout)
+        loop.run()
+        if state["timer"]:
+            GLib.source_remove(state["timer"])
+    if cleanup:
+        cleanup()
+    return state["value"]
@@ -1,13 +1,16 @@
 #!/bin/bash
 # gamemode_end.sh - Exécuté quand un jeu quitte
 
+# Dégeler les helpers du bureau (en une fois) et récupérer le bilan CPU de la session
+RECLAIMED=$(python3 ~/.config/waybar/scripts/gamemode_governor.py end)
+
 # Réactiver hypridle si pas déjà lancé
 if ! pgrep -x "hypridle" > /dev/null; then
     hypridle &
 fi
 
 # Signaler Waybar pour mise à jour immédiate
-pkill -SIGRTMIN+1 waybar
+python3 ~/.config/waybar/scripts/status_helper.py refresh gamemode
 
 # Notification
-notify-send "💤 Game Mode OFF" "Veille réactivée" -i preferences-desktop-screensaver
+notify-send "💤 Game Mode OFF" "Veille réactivée${RECLAIMED:+ - $RECLAIMED}" -i preferences-desktop-screensaver
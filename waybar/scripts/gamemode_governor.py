@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""
+Gouverneur de ressources du mode jeu - appelé par gamemode_start.sh / gamemode_end.sh
+  gamemode_governor.py start   # regroupe les helpers du bureau dans un scope et les gèle
+  gamemode_governor.py end     # les dégèle d'un coup, affiche le temps CPU récupéré
+  gamemode_governor.py status
+
+Les helpers en tâche de fond (HELPERS : lecteur du fond d'écran vidéo, auto-hide de
+waybar) sont rattachés au scope systemd utilisateur SCOPE (StartTransientUnit avec leurs
+PIDs, AttachProcessesToUnit s'il existe déjà). Le scope est gelé par le freezer cgroup v2
+(FreezeUnit) : un seul cgroup.freeze pour tous, le dégel est donc atomique. Si le freezer
+n'est pas disponible, le poids CPU du scope est abaissé à CPU_WEIGHT_GAMING à la place.
+
+mpv est mis en pause par son IPC avant le gel (pas d'image en attente côté compositeur),
+puis remis dans son état d'origine au dégel. Le contrôleur wallpaper_manager.py n'est pas
+gelé : abonné aux événements Hyprland, il serait déconnecté pendant le gel et arrêterait
+mpvpaper en partant. Il lit STATE_FILE et n'envoie aucune commande IPC au mpv gelé tant
+que la session est active (elle bloquerait jusqu'au timeout du socket).
+
+Temps CPU récupéré : consommation du scope pendant la session (cpu.stat) comparée à son
+rythme hors session, mesuré entre le dégel précédent et ce gel (à défaut, moyenne des
+helpers depuis leur lancement).
+
+Dépendances: python-gobject, systemd (session utilisateur), cgroup v2
+"""
+import json
+import os
+import socket
+import sys
+import time
+
+from gi.repository import Gio, GLib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from dbus_menu import Bus, log_to  # noqa: E402
+
+LOG_FILE = "/tmp/gamemode_governor.log"
+STATE_FILE = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "gamemode_governor.json")
+SCOPE = "gamemode-helpers.scope"
+HELPERS = ("waybar_manager.py", "mpvpaper")
+MPV_SOCKET = "/tmp/wallpaper_manager_mpv.sock"
+CPU_WEIGHT_GAMING = 1     # Repli sans freezer (100 = poids normal)
+CPU_WEIGHT_DEFAULT = 100
+
+SYSTEMD = "org.freedesktop.systemd1"
+SYSTEMD_PATH = "/org/freedesktop/systemd1"
+MANAGER = "org.freedesktop.systemd1.Manager"
+SCOPE_IFACE = "org.freedesktop.systemd1.Scope"
+CLK_TCK = os.sysconf("SC_CLK_TCK")
+
+
+def log(msg):
+    log_to(LOG_FILE, msg)
+
+
+def load_state():
+    try:
+        with open(STATE_FILE) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+def save_state(state):
+    tmp = STATE_FILE + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump(state, f)
+    os.replace(tmp, STATE_FILE)
+
+
+def find_helpers():
+    """PIDs des helpers de l'utilisateur (scan /proc, pas de pgrep)"""
+    pids = []
+    uid = os.getuid()
+    for entry in os.listdir("/proc"):
+        if not entry.isdigit():
+            continue
+        try:
+            if os.stat(f"/proc/{entry}").st_uid != uid:
+                continue
+            with open(f"/proc/{entry}/cmdline", "rb") as f:
+                argv = f.read().split(b"\0")
+        except OSError:
+            continue
+        # Nom du programme ou script lancé par l'interpréteur
+        names = {os.path.basename(arg.decode(errors="replace")) for arg in argv[:2]}
+        if names & set(HELPERS):
+            pids.append(int(entry))
+    return pids
+
+
+def lifetime_cpu_rate(pids):
+    """Moyenne CPU (s/s) des helpers depuis leur lancement"""
+    with open("/proc/uptime") as f:
+        uptime = float(f.read().split()[0])
+    cpu = elapsed = 0.0
+    for pid in pids:
+        try:
+            with open(f"/proc/{pid}/stat") as f:
+                fields = f.read().rsplit(")", 1)[1].split()
+        except OSError:
+            continue
+        cpu += (int(fields[11]) + int(fields[12])) / CLK_TCK      # utime + stime
+        elapsed = max(elapsed, uptime - int(fields[19]) / CLK_TCK)  # starttime
+    return cpu / elapsed if elapsed > 0 else 0.0
+
+
+def in_scope(pid):
+    try:
+        with open(f"/proc/{pid}/cgroup") as f:
+            return SCOPE in f.read()
+    except OSError:
+        return True  # Process terminé : rien à rattacher
+
+
+def mpv_command(*args):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.settimeout(1)
+        sock.connect(MPV_SOCKET)
+        sock.sendall(json.dumps({"command": list(args)}).encode() + b"\n")
+        for line in sock.makefile():
+            reply = json.loads(line)
+            if "event" not in reply:
+                return reply.get("data")
+    return None
+
+
+class Systemd:
+    def __init__(self):
+        self.bus = Bus(Gio.BusType.SESSION, SYSTEMD)
+
+    def manager(self, method, signature, *args, timeout=5000):
+        return self.bus.call(SYSTEMD_PATH, MANAGER, method, GLib.Variant(signature, args), timeout=timeout)
+
+    def adopt(self, pids):
+        """Rattache les helpers au scope, créé au besoin ; renvoie son cgroup"""
+        try:
+            path = self.manager("GetUnit", "(s)", SCOPE)[0]
+            cgroup = self.bus.get(path, SCOPE_IFACE, "ControlGroup")
+            outside = [pid for pid in pids if not in_scope(pid)]
+            if outside:
+                self.manager("AttachProcessesToUnit", "(ssau)", SCOPE, "/", outside)
+            return cgroup
+        except GLib.Error:
+            pass  # Pas encore de scope (ou plus aucun process dedans)
+        self.manager("StartTransientUnit", "(ssa(sv)a(sa(sv)))", SCOPE, "fail", [
+            ("PIDs", GLib.Variant("au", pids)),
+            ("Description", GLib.Variant("s", "Helpers du bureau gelés pendant le mode jeu")),
+            ("CPUAccounting", GLib.Variant("b", True)),
+        ], [])
+        for _ in range(50):
+            try:
+                path = self.manager("GetUnit", "(s)", SCOPE)[0]
+                cgroup = self.bus.get(path, SCOPE_IFACE, "ControlGroup")
+                if cgroup:
+                    return cgroup
+            except GLib.Error:
+                pass
+            time.sleep(0.01)
+        raise RuntimeError(f"{SCOPE} n'a pas démarré")
+
+    def freeze(self):
+        """Gel par le freezer cgroup v2, sinon poids CPU minimal ; renvoie le mode appliqué"""
+        try:
+            self.manager("FreezeUnit", "(s)", SCOPE)
+            return "freeze"
+        except GLib.Error as e:
+            log(f"FreezeUnit indisponible ({e.message}), repli sur CPUWeight={CPU_WEIGHT_GAMING}")
+        self.manager("SetUnitProperties", "(sba(sv))", SCOPE, True,
+                     [("CPUWeight", GLib.Variant("t", CPU_WEIGHT_GAMING))])
+        return "weight"
+
+    def thaw(self, mode):
+        if mode == "freeze":
+            self.manager("ThawUnit", "(s)", SCOPE)
+        else:
+            self.manager("SetUnitProperties", "(sba(sv))", SCOPE, True,
+                         [("CPUWeight", GLib.Variant("t", CPU_WEIGHT_DEFAULT))])
+
+
+def cpu_usage(cgroup):
+    """Temps CPU cumulé du cgroup (secondes)"""
+    with open(f"/sys/fs/cgroup{cgroup}/cpu.stat") as f:
+        for line in f:
+            key, value = line.split()
+            if key == "usage_usec":
+                return int(value) / 1e6
+    return 0.0
+
+
+def start():
+    state = load_state()
+    if state.get("active"):
+        log("Déjà actif, rien à faire")
+        return 0
+
+    pids = find_helpers()
+    if not pids:
+        log("Aucun helper à geler")
+        return 0
+
+    systemd = Systemd()
+    cgroup = systemd.adopt(pids)
+    now = time.monotonic()
+    usage = cpu_usage(cgroup)
+
+    # Rythme hors session : depuis le dernier dégel si le scope n'a pas été recréé entre-temps
+    if (state.get("cgroup") == cgroup and "thawed_at" in state and now > state["thawed_at"]
+            and usage >= state["usage_at_thaw"]):
+        rate = max(0.0, usage - state["usage_at_thaw"]) / (now - state["thawed_at"])
+    else:
+        rate = lifetime_cpu_rate(pids)
+
+    try:
+        mpv_paused = bool(mpv_command("get_property", "pause"))
+        mpv_command("set_property", "pause", True)
+    except (OSError, ValueError):
+        mpv_paused = None  # Pas de mpv (fond statique ou automatismes coupés)
+
+    mode = systemd.freeze()
+    save_state({"active": True, "mode": mode, "cgroup": cgroup, "pids": pids, "frozen_at": now,
+                "usage_at_freeze": usage, "rate": rate, "mpv_paused": mpv_paused})
+    log(f"Session démarrée : {len(pids)} helpers {pids} en mode {mode}, "
+        f"rythme hors session {rate * 1000:.1f} ms CPU/s")
+    return 0
+
+
+def end():
+    state = load_state()
+    if not state.get("active"):
+        log("Pas de session en cours")
+        return 0
+
+    systemd = Systemd()
+    try:
+        systemd.thaw(state["mode"])
+    except GLib.Error as e:
+        log(f"Dégel impossible : {e.message}")  # Scope disparu : plus rien de gelé
+    now = time.monotonic()
+
+    if state.get("mpv_paused") is False:
+        try:
+            mpv_command("set_property", "pause", False)
+        except (OSError, ValueError):
+            pass
+
+    try:
+        usage = cpu_usage(state["cgroup"])
+    except OSError:
+        usage = state["usage_at_freeze"]
+    duration = now - state["frozen_at"]
+    used = max(0.0, usage - state["usage_at_freeze"])
+    reclaimed = max(0.0, state["rate"] * duration - used)
+
+    save_state({"active": False, "cgroup": state["cgroup"], "thawed_at": now, "usage_at_thaw": usage,
+                "last_session": {"mode": state["mode"], "duration_s": round(duration, 1),
+                                 "cpu_used_s": round(used, 3), "cpu_reclaimed_s": round(reclaimed, 3)}})
+    log(f"Session terminée : {duration:.0f} s en mode {state['mode']}, CPU utilisé {used:.2f} s, "
+        f"récupéré {reclaimed:.2f} s")
+    print(f"{reclaimed:.1f} s CPU récupérées en {duration / 60:.0f} min")
+    return 0
+
+
+def status():
+    print(json.dumps(load_state(), indent=2))
+    return 0
+
+
+def main():
+    commands = {"start": start, "end": end, "status": status}
+    if len(sys.argv) != 2 or sys.argv[1] not in commands:
+        print(f"Usage: {sys.argv[0]} start|end|status", file=sys.stderr)
+        return 1
+    try:
+        return commands[sys.argv[1]]()
+    except (GLib.Error, OSError, RuntimeError) as e:
+        log(f"Erreur ({sys.argv[1]}) : {e}")
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
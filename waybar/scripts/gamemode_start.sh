@@ -4,8 +4,10 @@
 # Désactiver hypridle (gestionnaire de veille)
 killall hypridle
 
-# Signaler Waybar pour mise à jour immédiate
-pkill -SIGRTMIN+1 waybar
+# Geler les helpers du bureau (fond vidéo, rotation, auto-hide waybar) le temps du jeu
+python3 ~/.config/waybar/scripts/gamemode_governor.py start
+
+# Waybar est mis à jour par status_helper.py (fin de hypridle suivie par pidfd)
 
 # Notification
-notify-send "🎮 Game Mode ON" "Optimisations activées & Veille désactivée" -i input-gaming
+notify-send "🎮 Game Mode ON" "Optimisations activées, helpers gelés & Veille désactivée" -i input-gaming
@@ -10,4 +10,4 @@ else
     hypridle &
     notify-send "💤 Game Mode OFF" "Veille réactivée manuellement" -i preferences-desktop-screensaver
 fi
-pkill -SIGRTMIN+1 waybar
+python3 ~/.config/waybar/scripts/status_helper.py refresh gamemode
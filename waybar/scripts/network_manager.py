@@ -1,170 +1,280 @@
 #!/usr/bin/env python3
-import subprocess
-import sys
+"""
+Menu Wi-Fi pour Waybar - NetworkManager via D-Bus
+Le menu s'ouvre tout de suite avec les points d'accès que NetworkManager connaît déjà
+(son cache, tenu à jour par ses scans périodiques). Un nouveau scan est demandé en même
+temps et chaque réseau découvert (signal AccessPointAdded) est ajouté au menu ouvert.
+Aucun appel à nmcli, aucun sleep.
+"""
 import os
-import time
-import re
+import sys
+
+from gi.repository import Gio, GLib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from dbus_menu import Bus, StreamMenu, log_to, notify, wait_for  # noqa: E402
 
 # Log file for debugging
 LOG_FILE = "/tmp/waybar_wifi.log"
+SCAN_WINDOW = 10            # Durée pendant laquelle les résultats du scan alimentent le menu (secondes)
+ACTIVATION_TIMEOUT = 30     # Attente de l'activation d'une connexion (secondes)
+
+NM = "org.freedesktop.NetworkManager"
+NM_PATH = "/org/freedesktop/NetworkManager"
+NM_SETTINGS_PATH = "/org/freedesktop/NetworkManager/Settings"
+NM_DEVICE_TYPE_WIFI = 2
+NM_ACTIVE_CONNECTION_ACTIVATED = 2
+NM_ACTIVE_CONNECTION_DEACTIVATED = 4
+NM_802_11_AP_FLAGS_PRIVACY = 0x1
+NM_802_11_AP_SEC_KEY_MGMT_PSK = 0x100
+NM_802_11_AP_SEC_KEY_MGMT_802_1X = 0x200
+NM_802_11_AP_SEC_KEY_MGMT_SAE = 0x400
+
 
 def log(msg):
-    with open(LOG_FILE, "a") as f:
-        f.write(f"{time.strftime('%Y-%m-%d %H:%M:%S')} - {msg}\n")
+    log_to(LOG_FILE, msg)
 
-def run_cmd(cmd_list):
-    """Run command safely without shell=True"""
-    try:
-        log(f"Running: {' '.join(cmd_list)}")
-        result = subprocess.run(cmd_list, capture_output=True, text=True, timeout=20)
-        if result.returncode != 0:
-            log(f"Error ({result.returncode}): {result.stderr.strip()}")
-        return result.stdout.strip(), result.stderr.strip(), result.returncode
-    except Exception as e:
-        log(f"Exception: {str(e)}")
-        return "", str(e), 1
-
-def notify(title, message):
-    log(f"Notify: {title} - {message}")
-    subprocess.run(["notify-send", title, message])
-
-def rofi_menu(options, prompt="Network"):
-    option_str = "\n".join(options)
-    try:
-        # Use Popen to pipe options to rofi
-        proc = subprocess.Popen(["rofi", "-dmenu", "-p", prompt, "-i"], stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True)
-        stdout, _ = proc.communicate(input=option_str)
-        return stdout.strip() if proc.returncode == 0 else None
-    except:
-        return None
 
 def rofi_password(prompt="Password"):
-    try:
-        proc = subprocess.Popen(["rofi", "-dmenu", "-p", prompt, "-password", "-lines", "0"], stdout=subprocess.PIPE, text=True)
-        stdout, _ = proc.communicate()
-        return stdout.strip() if proc.returncode == 0 else None
-    except:
+    import subprocess
+    proc = subprocess.Popen(["rofi", "-dmenu", "-p", prompt, "-password", "-lines", "0"],
+                            stdin=subprocess.DEVNULL, stdout=subprocess.PIPE, text=True)
+    stdout, _ = proc.communicate()
+    return stdout.strip() if proc.returncode == 0 else None
+
+
+def bars(strength):
+    """Même échelle que nmcli"""
+    if strength > 80:
+        return "▂▄▆█"
+    if strength > 55:
+        return "▂▄▆_"
+    if strength > 30:
+        return "▂▄__"
+    if strength > 5:
+        return "▂___"
+    return "____"
+
+
+def security(ap):
+    parts = []
+    if ap["WpaFlags"]:
+        parts.append("WPA1")
+    if ap["RsnFlags"] & (NM_802_11_AP_SEC_KEY_MGMT_PSK | NM_802_11_AP_SEC_KEY_MGMT_802_1X):
+        parts.append("WPA2")
+    if ap["RsnFlags"] & NM_802_11_AP_SEC_KEY_MGMT_SAE:
+        parts.append("WPA3")
+    if ap["RsnFlags"] & NM_802_11_AP_SEC_KEY_MGMT_802_1X or ap["WpaFlags"] & NM_802_11_AP_SEC_KEY_MGMT_802_1X:
+        parts.append("802.1X")
+    if not parts and ap["Flags"] & NM_802_11_AP_FLAGS_PRIVACY:
+        parts.append("WEP")
+    return " ".join(parts)
+
+
+def key_mgmt(ap):
+    """key-mgmt d'un nouveau profil pour ce point d'accès ("" si ouvert, None si 802.1X seul)"""
+    flags = ap["WpaFlags"] | ap["RsnFlags"]
+    if flags & NM_802_11_AP_SEC_KEY_MGMT_PSK:
+        return "wpa-psk"  # WPA2, et WPA3 en mode transition
+    if flags & NM_802_11_AP_SEC_KEY_MGMT_SAE:
+        return "sae"
+    if flags & NM_802_11_AP_SEC_KEY_MGMT_802_1X:
+        return None  # Identité/certificats : pas de saisie possible depuis ce menu
+    if ap["Flags"] & NM_802_11_AP_FLAGS_PRIVACY:
+        return "none"  # WEP
+    return ""
+
+
+class NetworkManager:
+    def __init__(self):
+        self.bus = Bus(Gio.BusType.SYSTEM, NM)
+        self.device = None
+        for path in self.bus.call(NM_PATH, NM, "GetDevices")[0]:
+            if self.bus.get(path, f"{NM}.Device", "DeviceType") == NM_DEVICE_TYPE_WIFI:
+                self.device = path
+                break
+
+    def wifi_enabled(self):
+        return self.bus.get(NM_PATH, NM, "WirelessEnabled")
+
+    def set_wifi(self, enabled):
+        self.bus.set(NM_PATH, NM, "WirelessEnabled", GLib.Variant("b", enabled))
+
+    def active_connection(self):
+        """(chemin de la connexion active, SSID) du périphérique Wi-Fi"""
+        if not self.device:
+            return None, None
+        active = self.bus.get(self.device, f"{NM}.Device", "ActiveConnection")
+        if active == "/":
+            return None, None
+        return active, self.bus.get(active, f"{NM}.Connection.Active", "Id")
+
+    def access_point(self, path):
+        try:
+            ap = self.bus.get_all(path, f"{NM}.AccessPoint")
+        except GLib.Error:
+            return None  # Disparu entre le signal et la lecture
+        ssid = bytes(ap["Ssid"]).decode("utf-8", "replace")
+        if not ssid:
+            return None
+        return {"path": path, "ssid": ssid, "ssid_bytes": bytes(ap["Ssid"]), "strength": ap["Strength"],
+                "security": security(ap), "key_mgmt": key_mgmt(ap)}
+
+    def access_points(self):
+        """Points d'accès déjà connus de NetworkManager (pas d'attente de scan)"""
+        if not self.device:
+            return []
+        aps = [self.access_point(path)
+               for path in self.bus.call(self.device, f"{NM}.Device.Wireless", "GetAccessPoints")[0]]
+        return sorted((ap for ap in aps if ap), key=lambda ap: -ap["strength"])
+
+    def request_scan(self):
+        self.bus.conn.call(NM, self.device, f"{NM}.Device.Wireless", "RequestScan",
+                           GLib.Variant("(a{sv})", ({},)), None, Gio.DBusCallFlags.NONE, -1, None, None, None)
+
+    def find_profile(self, ssid_bytes):
+        for path in self.bus.call(NM_SETTINGS_PATH, f"{NM}.Settings", "ListConnections")[0]:
+            settings = self.bus.call(path, f"{NM}.Settings.Connection", "GetSettings")[0]
+            wireless = settings.get("802-11-wireless", {})
+            if bytes(wireless.get("ssid", [])) == ssid_bytes:
+                return path
         return None
 
-def get_active_ssid():
-    stdout, _, _ = run_cmd(["nmcli", "-t", "-f", "NAME,TYPE", "connection", "show", "--active"])
-    for line in stdout.split('\n'):
-        if '802-11-wireless' in line:
-            return line.split(':')[0]
-    return None
-
-def list_wifi_networks():
-    # Background rescan
-    subprocess.Popen(["nmcli", "device", "wifi", "rescan"])
-    time.sleep(1)
-    
-    stdout, _, _ = run_cmd(["nmcli", "-t", "-f", "SSID,BARS,SECURITY,IN-USE", "device", "wifi", "list"])
-    networks = []
-    seen = set()
-    
-    for line in stdout.split('\n'):
-        if not line: continue
-        parts = re.split(r'(?<!\\):', line) # Split by colon not preceded by backslash
-        if len(parts) >= 4:
-            ssid = parts[0].replace('\\:', ':')
-            bars = parts[1]
-            security = parts[2]
-            in_use = parts[3]
-            
-            if not ssid or ssid in seen: continue
-            seen.add(ssid)
-            
-            display = f"{ssid} ({bars}) {security}"
-            if in_use == "*":
-                display = f"<b>{ssid}</b> <span color='green'>(Connected)</span>"
-            
-            networks.append({'ssid': ssid, 'display': display, 'security': security})
-    return networks
-
-def connect(ssid, security):
+    def wait_activation(self, active_path):
+        """True si la connexion atteint l'état activé, False si elle échoue ou expire"""
+        def setup(done):
+            subscription = self.bus.subscribe(f"{NM}.Connection.Active", "StateChanged", active_path,
+                                              lambda _p, args: done(args[0] == NM_ACTIVE_CONNECTION_ACTIVATED)
+                                              if args[0] in (NM_ACTIVE_CONNECTION_ACTIVATED,
+                                                             NM_ACTIVE_CONNECTION_DEACTIVATED) else None)
+            try:
+                state = self.bus.get(active_path, f"{NM}.Connection.Active", "State")
+                if state in (NM_ACTIVE_CONNECTION_ACTIVATED, NM_ACTIVE_CONNECTION_DEACTIVATED):
+                    done(state == NM_ACTIVE_CONNECTION_ACTIVATED)
+            except GLib.Error:
+                done(False)
+            return lambda: self.bus.unsubscribe(subscription)
+        return bool(wait_for(setup, ACTIVATION_TIMEOUT))
+
+    def activate(self, profile, ap):
+        active = self.bus.call(NM_PATH, NM, "ActivateConnection",
+                               GLib.Variant("(ooo)", (profile, self.device, ap["path"])))[0]
+        return self.wait_activation(active)
+
+    def add_and_activate(self, ap, password):
+        """(chemin du nouveau profil, True s'il s'est activé)"""
+        settings = {
+            "connection": {"id": GLib.Variant("s", ap["ssid"]), "type": GLib.Variant("s", "802-11-wireless")},
+            "802-11-wireless": {"ssid": GLib.Variant("ay", ap["ssid_bytes"])},
+        }
+        # key-mgmt explicite : évite l'erreur "property is missing" de certaines box (HUAWEI)
+        if ap["key_mgmt"] == "none":
+            settings["802-11-wireless-security"] = {"key-mgmt": GLib.Variant("s", "none"),
+                                                    "wep-key0": GLib.Variant("s", password),
+                                                    "wep-key-type": GLib.Variant("u", 1)}
+        elif ap["key_mgmt"]:
+            settings["802-11-wireless-security"] = {"key-mgmt": GLib.Variant("s", ap["key_mgmt"]),
+                                                    "psk": GLib.Variant("s", password)}
+        profile, active = self.bus.call(NM_PATH, NM, "AddAndActivateConnection",
+                                        GLib.Variant("(a{sa{sv}}oo)", (settings, self.device, ap["path"])))
+        return profile, self.wait_activation(active)
+
+    def delete_profile(self, profile):
+        self.bus.call(profile, f"{NM}.Settings.Connection", "Delete")
+
+
+def connect(nm, ap):
+    ssid = ap["ssid"]
     notify("Wi-Fi", f"Tentative: {ssid}")
-    
-    # 1. Try connecting with existing profile
-    _, stderr, code = run_cmd(["nmcli", "connection", "up", "id", ssid])
-    if code == 0:
-        notify("Wi-Fi", f"Connecté à {ssid}")
-        return True
-    
-    # 2. Ask for password if connection up failed
-    password = rofi_password(f"Password for {ssid}")
-    if password is None: return False
-    
-    # 3. Use 'device wifi connect' which is more robust for creating/updating profiles
-    cmd = ["nmcli", "device", "wifi", "connect", ssid]
-    if password:
-        cmd += ["password", password]
-    
-    stdout, stderr, code = run_cmd(cmd)
-    
-    if code == 0:
-        notify("Wi-Fi", f"Connecté à {ssid}")
-        return True
-    
-    # 4. Fallback for HUAWEI/Property issues
-    if "property is missing" in stderr or "secrets" in stderr.lower():
-        notify("Wi-Fi", "Mode secours: Forçage WPA2...")
-        run_cmd(["nmcli", "connection", "delete", "id", ssid])
-        
-        # Add manually
-        run_cmd(["nmcli", "connection", "add", "type", "wifi", "con-name", ssid, "ifname", "wlan0", "ssid", ssid])
-        if password:
-            run_cmd(["nmcli", "connection", "modify", ssid, "wifi-sec.key-mgmt", "wpa-psk", "wifi-sec.psk", password])
-        
-        _, stderr, code = run_cmd(["nmcli", "connection", "up", "id", ssid])
-        if code == 0:
-            notify("Wi-Fi", f"Connecté à {ssid} (Mode manuel)")
+    try:
+        # 1. Profil existant
+        profile = nm.find_profile(ap["ssid_bytes"])
+        if profile and nm.activate(profile, ap):
+            notify("Wi-Fi", f"Connecté à {ssid}")
             return True
 
-    notify("Wi-Fi", f"Échec: {stderr or 'Erreur inconnue'}")
+        # 2. Nouveau profil (mot de passe si le réseau est sécurisé). Un profil existant
+        #    (mot de passe changé ou profil incomplet) n'est remplacé qu'une fois le nouveau connecté
+        if ap["key_mgmt"] is None:
+            notify("Wi-Fi", f"{ssid} : réseau 802.1X, à configurer avec nm-connection-editor")
+            return False
+        password = ""
+        if ap["key_mgmt"]:
+            password = rofi_password(f"Password for {ssid}")
+            if password is None:
+                return False
+        new_profile, activated = nm.add_and_activate(ap, password)
+        if activated:
+            if profile:
+                nm.delete_profile(profile)
+            notify("Wi-Fi", f"Connecté à {ssid}")
+            return True
+        nm.delete_profile(new_profile)
+        notify("Wi-Fi", f"Échec: {ssid}")
+    except GLib.Error as e:
+        log(f"Connexion à {ssid}: {e.message}")
+        notify("Wi-Fi", f"Échec: {e.message}")
     return False
 
+
+def display(ap, active_ssid):
+    if ap["ssid"] == active_ssid:
+        return f"<b>{ap['ssid']}</b> <span color='green'>(Connected)</span>"
+    return f"{ap['ssid']} ({bars(ap['strength'])}) {ap['security']}".rstrip()
+
+
 def main():
-    log("--- Waybar Network Menu Started ---")
-    active = get_active_ssid()
-    networks = list_wifi_networks()
-    
-    wifi_on, _, _ = run_cmd(["nmcli", "radio", "wifi"])
-    wifi_on = wifi_on.strip() == "enabled"
-    
-    options = []
-    options.append("OFF: Disable Wi-Fi" if wifi_on else "ON: Enable Wi-Fi")
-    if active:
-        options.append(f"DISCONNECT: {active}")
-    
+    nm = NetworkManager()
+    active, active_ssid = nm.active_connection()
+    wifi_on = nm.wifi_enabled()
+
+    options = ["OFF: Disable Wi-Fi" if wifi_on else "ON: Enable Wi-Fi"]
+    if active_ssid:
+        options.append(f"DISCONNECT: {active_ssid}")
     options.append("--- Networks ---")
-    for n in networks:
-        options.append(n['display'])
-        
-    selected = rofi_menu(options)
-    if not selected: return
-
-    if "Disable Wi-Fi" in selected:
-        run_cmd(["nmcli", "radio", "wifi", "off"])
-        notify("Wi-Fi", "Désactivé")
-    elif "Enable Wi-Fi" in selected:
-        run_cmd(["nmcli", "radio", "wifi", "on"])
-        notify("Wi-Fi", "Activé")
-    elif selected.startswith("DISCONNECT:"):
-        run_cmd(["nmcli", "connection", "down", "id", active])
-        notify("Wi-Fi", f"Déconnecté de {active}")
-    elif selected == "--- Networks ---":
-        pass
+
+    networks = {}
+    for ap in nm.access_points():
+        if ap["ssid"] not in {n["ssid"] for n in networks.values()}:
+            networks[display(ap, active_ssid)] = ap
+    menu = StreamMenu(options + list(networks), "Network")
+
+    # Scan en parallèle du menu : les nouveaux réseaux s'ajoutent à la liste affichée
+    subscription = None
+    if wifi_on and nm.device:
+        def on_ap_added(_path, args):
+            ap = nm.access_point(args[0])
+            if ap and ap["ssid"] not in {n["ssid"] for n in networks.values()}:
+                networks[display(ap, active_ssid)] = ap
+                menu.append([display(ap, active_ssid)])
+        subscription = nm.bus.subscribe(f"{NM}.Device.Wireless", "AccessPointAdded", nm.device, on_ap_added)
+        nm.request_scan()
+        GLib.timeout_add_seconds(SCAN_WINDOW, lambda: menu.close_input() or GLib.SOURCE_REMOVE)
     else:
-        # Match selection to ssid
-        # Selection might contain HTML tags or just ssid
-        target = None
-        for n in networks:
-            if n['display'] == selected:
-                target = n
-                break
-        
-        if target:
-            connect(target['ssid'], target['security'])
+        menu.close_input()
+
+    selected = menu.run()
+    if subscription:
+        nm.bus.unsubscribe(subscription)
+    if not selected:
+        return
+
+    try:
+        if "Disable Wi-Fi" in selected:
+            nm.set_wifi(False)
+            notify("Wi-Fi", "Désactivé")
+        elif "Enable Wi-Fi" in selected:
+            nm.set_wifi(True)
+            notify("Wi-Fi", "Activé")
+        elif selected.startswith("DISCONNECT:"):
+            nm.bus.call(NM_PATH, NM, "DeactivateConnection", GLib.Variant("(o)", (active,)))
+            notify("Wi-Fi", f"Déconnecté de {active_ssid}")
+        elif selected in networks:
+            connect(nm, networks[selected])
+    except GLib.Error as e:
+        log(f"{selected}: {e.message}")
+        notify("Wi-Fi", f"Échec: {e.message}")
+
 
 if __name__ == "__main__":
     main()
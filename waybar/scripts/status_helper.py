@@ -0,0 +1,353 @@
+#!/usr/bin/env python3
+"""
+Helper de statut unique pour les modules custom de Waybar
+Usage:
+  status_helper.py watch <module>     # exec du module : flux JSON, une ligne par changement
+  status_helper.py refresh <module>   # force la relecture d'un module (clics, scripts gamemode)
+  status_helper.py stats              # compteurs de mises à jour et coût par module
+  status_helper.py daemon             # lancé automatiquement par le premier watch
+
+Un seul daemon surveille l'état par événements au lieu de forker à chaque intervalle :
+- gamemode       : présence de hypridle, fin du process suivie par pidfd
+- transparency   : /tmp/transparency_state suivi par inotify
+- system_update  : valeur en cache d'update_checker.py servie dès le démarrage, vérification
+                   (téléchargement conditionnel des bases) toutes les heures et au clic droit,
+                   recomptage sans réseau après chaque changement de /var/lib/pacman/local (inotify)
+
+Chaque module reçoit la valeur courante à la connexion, puis seulement quand elle change.
+
+Dépendances: python-gobject
+"""
+import fcntl
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+from gi.repository import Gio, GLib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from update_checker import load_status, module_value  # noqa: E402
+
+# Configuration
+RUNTIME_DIR = os.environ.get("XDG_RUNTIME_DIR", "/tmp")
+SOCKET_PATH = os.path.join(RUNTIME_DIR, "waybar_status.sock")
+LOCK_PATH = os.path.join(RUNTIME_DIR, "waybar_status.lock")
+LOG_FILE = "/tmp/waybar_status.log"
+SCRIPTS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+TRANSPARENCY_STATE = "/tmp/transparency_state"
+PACMAN_DB = "/var/lib/pacman/local"
+UPDATE_INTERVAL = 3600       # Vérification des mises à jour (secondes)
+PACMAN_SETTLE = 5            # Attente après une modification de la base pacman (secondes)
+HYPRIDLE_RESCAN = 60         # Re-scan de /proc tant que hypridle est absent (démarrage hors scripts)
+CONNECT_TIMEOUT = 2.0        # Attente du daemon par les clients (secondes)
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
+
+
+def find_process(name):
+    """PID d'un process par son nom (scan de /proc, sans pgrep)"""
+    for pid in filter(str.isdigit, os.listdir("/proc")):
+        try:
+            with open(f"/proc/{pid}/comm") as f:
+                if f.read().strip() == name:
+                    return int(pid)
+        except OSError:
+            pass
+    return None
+
+
+class Module:
+    """État publié d'un module et ses abonnés"""
+
+    def __init__(self, name):
+        self.name = name
+        self.value = None
+        self.subscribers = []
+        self.refreshes = 0       # Relectures de l'état
+        self.updates = 0         # Valeurs effectivement envoyées (changements)
+        self.cost = 0.0          # Temps passé à relire l'état (secondes)
+
+    def publish(self, value, cost):
+        self.refreshes += 1
+        self.cost += cost
+        if value == self.value:
+            return
+        self.value = value
+        self.updates += 1
+        line = (json.dumps(value, ensure_ascii=False) + "\n").encode()
+        for conn in list(self.subscribers):
+            try:
+                conn.sendall(line)
+            except OSError:
+                self.subscribers.remove(conn)
+                conn.close()
+
+    def stats(self):
+        return {
+            "subscribers": len(self.subscribers),
+            "refreshes": self.refreshes,
+            "updates": self.updates,
+            "cost_ms": round(self.cost * 1000, 2),
+            "avg_cost_ms": round(self.cost * 1000 / self.refreshes, 2) if self.refreshes else 0,
+        }
+
+
+class StatusHelper:
+    def __init__(self):
+        self.modules = {name: Module(name) for name in ("gamemode", "transparency", "system_update")}
+        self.refreshers = {
+            "gamemode": self.refresh_gamemode,
+            "transparency": self.refresh_transparency,
+            "system_update": self.refresh_system_update,
+        }
+        self.started = time.monotonic()
+
+        # gamemode : pidfd de hypridle, sinon re-scan lent
+        self.hypridle_fd = -1
+        self.hypridle_rescan = 0
+
+        # transparency : inotify sur le fichier d'état
+        self.transparency_monitor = Gio.File.new_for_path(TRANSPARENCY_STATE).monitor_file(
+            Gio.FileMonitorFlags.NONE, None)
+        self.transparency_monitor.connect("changed", self.on_transparency_changed)
+
+        # system_update : timer horaire + inotify sur la base pacman
+        self.update_proc = None
+        self.update_pending = None   # Vérification demandée pendant une autre (avec téléchargement ?)
+        self.pacman_timer = 0
+        self.pacman_monitor = Gio.File.new_for_path(PACMAN_DB).monitor_directory(Gio.FileMonitorFlags.NONE, None)
+        self.pacman_monitor.connect("changed", self.on_pacman_changed)
+        GLib.timeout_add_seconds(UPDATE_INTERVAL, self.on_update_timer)
+
+        self.refresh_gamemode()
+        self.refresh_transparency()
+        # Cache encore frais : servi tel quel, la prochaine vérification attend le timer
+        status = load_status()
+        if status:
+            self.modules["system_update"].publish(module_value(status), 0.0)
+        if not status or time.time() - status.get("checked_at", 0) > UPDATE_INTERVAL:
+            self.refresh_system_update()
+
+    # --- gamemode ---
+
+    def refresh_gamemode(self):
+        start = time.monotonic()
+        if self.hypridle_fd < 0:
+            pid = find_process("hypridle")
+            if pid:
+                try:
+                    self.hypridle_fd = os.pidfd_open(pid)
+                    GLib.io_add_watch(self.hypridle_fd, GLib.PRIORITY_DEFAULT, GLib.IO_IN, self.on_hypridle_exit)
+                except OSError:
+                    pass  # Process terminé entre le scan et pidfd_open
+
+        idle_active = self.hypridle_fd >= 0
+        if idle_active and self.hypridle_rescan:
+            GLib.source_remove(self.hypridle_rescan)
+            self.hypridle_rescan = 0
+        elif not idle_active and not self.hypridle_rescan:
+            self.hypridle_rescan = GLib.timeout_add_seconds(HYPRIDLE_RESCAN, self.on_hypridle_rescan)
+
+        self.modules["gamemode"].publish({
+            "text": "" if idle_active else "",
+            "alt": "off" if idle_active else "on",
+            "class": "off" if idle_active else "on",
+        }, time.monotonic() - start)
+
+    def on_hypridle_exit(self, fd, _condition):
+        os.close(fd)
+        self.hypridle_fd = -1
+        self.refresh_gamemode()
+        return GLib.SOURCE_REMOVE
+
+    def on_hypridle_rescan(self):
+        self.hypridle_rescan = 0
+        self.refresh_gamemode()
+        return GLib.SOURCE_REMOVE
+
+    # --- transparency ---
+
+    def refresh_transparency(self):
+        start = time.monotonic()
+        try:
+            with open(TRANSPARENCY_STATE) as f:
+                enabled = f.read().strip() != "0"
+        except OSError:
+            enabled = True  # Transparent par défaut (toggle_transparency.sh)
+
+        if enabled:
+            value = {"text": "", "tooltip": "Transparence: ACTIVÉE (Clic pour désactiver)",
+                     "class": "enabled", "alt": "enabled"}
+        else:
+            value = {"text": "", "tooltip": "Transparence: DÉSACTIVÉE (Clic pour activer)",
+                     "class": "disabled", "alt": "disabled"}
+        self.modules["transparency"].publish(value, time.monotonic() - start)
+
+    def on_transparency_changed(self, _monitor, _file, _other, event):
+        if event in (Gio.FileMonitorEvent.CHANGES_DONE_HINT, Gio.FileMonitorEvent.DELETED):
+            self.refresh_transparency()
+
+    # --- system_update ---
+
+    def refresh_system_update(self, fetch=True):
+        """update_checker.py check en asynchrone (réseau), une seule vérification à la fois"""
+        if self.update_proc:
+            self.update_pending = fetch or bool(self.update_pending)
+            return
+        start = time.monotonic()
+        argv = [sys.executable, os.path.join(SCRIPTS_DIR, "update_checker.py"), "check"]
+        if not fetch:
+            argv.append("--no-fetch")
+        self.update_proc = Gio.Subprocess.new(argv, Gio.SubprocessFlags.STDOUT_PIPE)
+        self.update_proc.communicate_utf8_async(None, None, self.on_system_update_done, start)
+
+    def on_system_update_done(self, proc, result, start):
+        self.update_proc = None
+        try:
+            _ok, stdout, _stderr = proc.communicate_utf8_finish(result)
+            value = json.loads(stdout)
+        except (GLib.Error, ValueError) as e:
+            log(f"system_update: sortie invalide ({e})")
+            value = {"text": "󰒑", "tooltip": "Cannot fetch updates. Right-click to retry."}
+        self.modules["system_update"].publish(value, time.monotonic() - start)
+
+        if self.update_pending is not None:
+            fetch, self.update_pending = self.update_pending, None
+            self.refresh_system_update(fetch)
+
+    def on_update_timer(self):
+        self.refresh_system_update()
+        return GLib.SOURCE_CONTINUE
+
+    def on_pacman_changed(self, *_args):
+        # Un pacman -Syu touche des centaines d'entrées : une seule vérification à la fin
+        if self.pacman_timer:
+            GLib.source_remove(self.pacman_timer)
+        self.pacman_timer = GLib.timeout_add_seconds(PACMAN_SETTLE, self.on_pacman_settled)
+
+    def on_pacman_settled(self):
+        self.pacman_timer = 0
+        self.refresh_system_update(fetch=False)  # Bases sync inchangées : pas de réseau
+        return GLib.SOURCE_REMOVE
+
+    # --- Socket ---
+
+    def on_connection(self, server, _condition):
+        conn, _ = server.accept()
+        try:
+            conn.settimeout(1.0)
+            request = conn.recv(256).decode().split()
+            conn.settimeout(None)
+        except (OSError, UnicodeDecodeError):
+            conn.close()
+            return GLib.SOURCE_CONTINUE
+
+        command, name = (request + ["", ""])[:2]
+        if command == "watch" and name in self.modules:
+            module = self.modules[name]
+            module.subscribers.append(conn)
+            if module.value is not None:
+                conn.sendall((json.dumps(module.value, ensure_ascii=False) + "\n").encode())
+            return GLib.SOURCE_CONTINUE
+
+        if command == "refresh" and name in self.refreshers:
+            self.refreshers[name]()
+        elif command == "stats":
+            stats = {name: module.stats() for name, module in self.modules.items()}
+            stats["uptime_s"] = round(time.monotonic() - self.started)
+            conn.sendall((json.dumps(stats, indent=2) + "\n").encode())
+        conn.close()
+        return GLib.SOURCE_CONTINUE
+
+    def log_stats(self):
+        for name, module in self.modules.items():
+            s = module.stats()
+            log(f"{name}: {s['updates']} mises à jour / {s['refreshes']} relectures, {s['cost_ms']} ms au total")
+
+
+def run_daemon():
+    lock = open(LOCK_PATH, "w")
+    try:
+        fcntl.flock(lock, fcntl.LOCK_EX | fcntl.LOCK_NB)
+    except OSError:
+        return 0  # Déjà lancé par un autre module
+
+    if os.path.exists(SOCKET_PATH):
+        os.unlink(SOCKET_PATH)
+    server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    server.bind(SOCKET_PATH)
+    server.listen(8)
+
+    log("=== Démarrage helper de statut ===")
+    helper = StatusHelper()
+    GLib.io_add_watch(server, GLib.PRIORITY_DEFAULT, GLib.IO_IN, helper.on_connection)
+
+    loop = GLib.MainLoop()
+    for sig in (2, 15):  # SIGINT, SIGTERM
+        GLib.unix_signal_add(GLib.PRIORITY_DEFAULT, sig, loop.quit)
+    loop.run()
+
+    helper.log_stats()
+    os.unlink(SOCKET_PATH)
+    log("=== Arrêt helper de statut ===")
+    return 0
+
+
+def connect(spawn):
+    """Connexion au daemon, lancé à la demande si absent"""
+    deadline = time.monotonic() + CONNECT_TIMEOUT
+    spawned = False
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(SOCKET_PATH)
+            return sock
+        except OSError:
+            sock.close()
+        if not spawn or time.monotonic() > deadline:
+            return None
+        if not spawned:
+            subprocess.Popen([sys.executable, os.path.abspath(__file__), "daemon"],
+                             stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                             start_new_session=True)
+            spawned = True
+        time.sleep(0.05)
+
+
+def main():
+    command = sys.argv[1] if len(sys.argv) > 1 else ""
+    name = sys.argv[2] if len(sys.argv) > 2 else ""
+
+    if command == "daemon":
+        return run_daemon()
+
+    if command not in ("watch", "refresh", "stats"):
+        print(__doc__)
+        return 1
+
+    sock = connect(spawn=command == "watch")
+    if sock is None:
+        print("Helper de statut injoignable", file=sys.stderr)
+        return 1
+    sock.sendall(f"{command} {name}\n".encode())
+
+    # watch : recopie le flux vers waybar jusqu'à l'arrêt du daemon
+    out = sys.stdout.buffer
+    while True:
+        data = sock.recv(4096)
+        if not data:
+            break
+        out.write(data)
+        out.flush()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
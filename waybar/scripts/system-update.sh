@@ -2,7 +2,8 @@
 #
 # Check for official and AUR package updates and upgrade them. When run with the
 # 'module' argument, output the status icon and update counts in JSON format for
-# Waybar
+# Waybar, served from the update_checker.py cache (conditional sync DB fetches,
+# see that script)
 #
 # Requirements:
 # 	- checkupdates (pacman-contrib)
@@ -75,39 +76,19 @@ update-packages() {
 	read -rs -n 1 -p 'Press any key to exit...'
 }
 
-display-module() {
-	if [[ $is_online == false ]]; then
-		echo "{ \"text\": \"󰒑\", \"tooltip\": \"Cannot fetch updates. Right-click to retry.\" }"
-		return 0
-	fi
-
-	local tooltip="<b>Official</b>: $repo"
-	if [[ -n $helper ]]; then
-		tooltip+="\n<b>AUR($helper)</b>: $aur"
-	fi
-
-	local total=$((repo + aur))
-	if ((total == 0)); then
-		echo "{ \"text\": \"󰸟\", \"tooltip\": \"No updates available\" }"
-	else
-		echo "{ \"text\": \"󰄠\", \"tooltip\": \"$tooltip\" }"
-	fi
-}
-
 main() {
 	detect-helper
 
 	case $1 in
 		'module')
-			check-updates
-			display-module
+			python3 "$(dirname "$(readlink -f "$0")")/update_checker.py" module
 			;;
 		*)
 			printf '%bChecking for updates...%b' "$BLU" "$RST"
 			check-updates
 			update-packages
-			# use signal to update the module
-			pkill -RTMIN+1 waybar
+			# refresh the module through the status helper
+			python3 ~/.config/waybar/scripts/status_helper.py refresh system_update
 			;;
 	esac
 }
@@ -20,8 +20,7 @@ if [[ "$ACTION" == "toggle" ]]; then
         hyprctl keyword decoration:inactive_opacity 0.8
         echo "1" > "$STATE_FILE"
     fi
-    # Rafraîchir waybar via signal (si nécessaire)
-    pkill -RTMIN+10 waybar
+    # Waybar suit le fichier d'état via status_helper.py (inotify)
 fi
 
 # Renvoyer le statut JSON pour Waybar
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+Vérification des mises à jour pour le module system_update de Waybar
+Usage:
+  update_checker.py module               # JSON du module depuis le cache (vérifie si pas de cache)
+  update_checker.py check [--no-fetch]   # vérifie, met le cache à jour et affiche le JSON du module
+  update_checker.py stats                # historique des vérifications et octets transférés
+
+Remplace checkupdates, qui retélécharge toutes les bases sync dans un dossier temporaire à
+chaque appel. Ici les bases sync sont gardées dans CACHE_DIR/db/sync, et une base n'est
+retéléchargée que si elle a changé sur le miroir (If-None-Match / If-Modified-Since, en-têtes
+comparés aussi pour les miroirs et file:// qui les ignorent). Les paquets à mettre à jour
+sont comptés par pacman -Qu sur ce dossier, dont la base locale est un lien vers celle du
+système, puis par l'assistant AUR s'il y en a un.
+--no-fetch recompte sans toucher aux miroirs (après un pacman -Syu par exemple).
+
+Dépôts et miroirs : pacman-conf. Miroir de test (file:// ou http://127.0.0.1) :
+  UPDATE_CHECKER_MIRROR='http://127.0.0.1:8000/$repo' UPDATE_CHECKER_REPOS='core extra'
+
+Dépendances: pacman
+"""
+import fcntl
+import json
+import os
+import shutil
+import subprocess
+import sys
+import time
+import urllib.error
+import urllib.request
+
+# Configuration
+CACHE_DIR = os.path.join(os.environ.get("XDG_CACHE_HOME", os.path.expanduser("~/.cache")), "update_checker")
+DB_DIR = os.path.join(CACHE_DIR, "db")
+SYNC_DIR = os.path.join(DB_DIR, "sync")
+STATUS_FILE = os.path.join(CACHE_DIR, "status.json")
+LOCK_FILE = os.path.join(CACHE_DIR, "lock")
+LOG_FILE = "/tmp/update_checker.log"
+PACMAN_LOCAL = "/var/lib/pacman/local"
+AUR_HELPERS = ("aura", "paru", "pikaur", "trizen", "yay")
+TIMEOUT = 10                 # Par requête et par commande (secondes)
+HISTORY = 48                 # Vérifications gardées pour stats
+CHUNK = 65536
+
+
+def log(msg):
+    with open(LOG_FILE, "a") as f:
+        f.write(f"{time.strftime('%H:%M:%S')} {msg}\n")
+
+
+def load_json(path):
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+def save_json(path, value):
+    tmp = path + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump(value, f)
+    os.replace(tmp, path)
+
+
+def load_status():
+    return load_json(STATUS_FILE)
+
+
+def module_value(status):
+    """JSON du module waybar (mêmes icônes et textes que system-update.sh)"""
+    if not status.get("online"):
+        return {"text": "󰒑", "tooltip": "Cannot fetch updates. Right-click to retry."}
+    if status["repo"] + status["aur"] == 0:
+        return {"text": "󰸟", "tooltip": "No updates available"}
+    tooltip = f"<b>Official</b>: {status['repo']}"
+    if status.get("helper"):
+        tooltip += f"\n<b>AUR({status['helper']})</b>: {status['aur']}"
+    return {"text": "󰄠", "tooltip": tooltip}
+
+
+def run(argv):
+    return subprocess.run(argv, capture_output=True, text=True, timeout=TIMEOUT, check=True).stdout
+
+
+def repositories():
+    """[(dépôt, [miroirs])] dans l'ordre de pacman.conf"""
+    mirror = os.environ.get("UPDATE_CHECKER_MIRROR")
+    if mirror:
+        arch = os.uname().machine
+        repos = os.environ.get("UPDATE_CHECKER_REPOS", "core extra multilib").split()
+        return [(repo, [mirror.replace("$repo", repo).replace("$arch", arch)]) for repo in repos]
+    return [(repo, run(["pacman-conf", "--repo", repo, "Server"]).split())
+            for repo in run(["pacman-conf", "--repo-list"]).split()]
+
+
+def fetch(repo, servers):
+    """Met à jour SYNC_DIR/<repo>.db si le miroir en a une autre version ; renvoie (état, octets reçus)"""
+    path = os.path.join(SYNC_DIR, f"{repo}.db")
+    meta_path = path + ".meta"
+    meta = load_json(meta_path) if os.path.exists(path) else {}
+    error = None
+    for server in servers:
+        url = f"{server.rstrip('/')}/{repo}.db"
+        # Un ETag n'a de sens que pour le miroir qui l'a donné
+        etag = meta.get("etag") if meta.get("url") == url else None
+        request = urllib.request.Request(url, headers={"User-Agent": "update_checker"})
+        if etag:
+            request.add_header("If-None-Match", etag)
+        if meta.get("last_modified"):
+            request.add_header("If-Modified-Since", meta["last_modified"])
+        try:
+            with urllib.request.urlopen(request, timeout=TIMEOUT) as response:
+                new_etag = response.headers.get("ETag")
+                modified = response.headers.get("Last-Modified")
+                # Miroir qui ignore les en-têtes conditionnels : même version, corps non lu
+                if (etag and new_etag == etag) or (not new_etag and modified and modified == meta.get("last_modified")):
+                    return "inchangé", 0
+                received = 0
+                with open(path + ".part", "wb") as f:
+                    while chunk := response.read(CHUNK):
+                        f.write(chunk)
+                        received += len(chunk)
+            os.replace(path + ".part", path)
+            save_json(meta_path, {"url": url, "etag": new_etag, "last_modified": modified})
+            return "téléchargé", received
+        except urllib.error.HTTPError as e:
+            if e.code == 304:
+                return "inchangé", 0
+            error = e
+        except (urllib.error.URLError, OSError) as e:
+            error = e
+    log(f"{repo}: aucun miroir joignable ({error})")
+    return "erreur", 0
+
+
+def count_repo_updates():
+    """pacman -Qu sur les bases sync du cache (comme checkupdates, sans le téléchargement)"""
+    local = os.path.join(DB_DIR, "local")
+    if not os.path.islink(local):
+        os.symlink(PACMAN_LOCAL, local)
+    result = subprocess.run(["pacman", "-Qqu", "--dbpath", DB_DIR, "--logfile", "/dev/null"],
+                            capture_output=True, text=True, timeout=TIMEOUT)
+    # 1 = rien à mettre à jour
+    if result.returncode not in (0, 1):
+        raise OSError(result.stderr.strip() or f"pacman -Qu : code {result.returncode}")
+    return len(result.stdout.split())
+
+
+def count_aur_updates(helper):
+    result = subprocess.run([helper, "-Quaq"], capture_output=True, text=True, timeout=TIMEOUT)
+    # Code non nul sans sortie = aucune mise à jour
+    if result.returncode != 0 and result.stdout.strip():
+        raise OSError(f"{helper} -Qua : code {result.returncode}")
+    return len(result.stdout.split())
+
+
+def check(fetch_dbs=True):
+    os.makedirs(SYNC_DIR, exist_ok=True)
+    with open(LOCK_FILE, "w") as lock:
+        fcntl.flock(lock, fcntl.LOCK_EX)  # Une vérification à la fois (daemon, clic, terminal)
+        status = load_status()
+        start = time.monotonic()
+        record = {"time": int(time.time()), "fetch": fetch_dbs, "bytes": 0, "repos": {}}
+
+        online = status.get("online", False)
+        if fetch_dbs:
+            try:
+                repos = repositories()
+            except (OSError, subprocess.SubprocessError) as e:
+                log(f"Dépôts illisibles ({e})")
+                repos = []
+            for repo, servers in repos:
+                state, received = fetch(repo, servers)
+                record["repos"][repo] = state
+                record["bytes"] += received
+            # Bases en cache encore utilisables si seulement une partie des miroirs a échoué
+            online = any(state != "erreur" for state in record["repos"].values())
+
+        helper = next((h for h in AUR_HELPERS if shutil.which(h)), None)
+        repo = aur = 0
+        if online:
+            try:
+                repo = count_repo_updates()
+                aur = count_aur_updates(helper) if helper else 0
+            except (OSError, subprocess.SubprocessError) as e:
+                log(f"Comptage impossible ({e})")
+                online = False
+
+        record["duration_ms"] = round((time.monotonic() - start) * 1000)
+        checks = (status.get("checks", []) + [record])[-HISTORY:]
+        status = {"online": online, "repo": repo, "aur": aur, "helper": helper,
+                  "checked_at": record["time"], "checks": checks}
+        save_json(STATUS_FILE, status)
+
+    repos = ", ".join(f"{name} {state}" for name, state in record["repos"].items()) or "sans téléchargement"
+    log(f"Vérification : {record['bytes']} octets reçus ({repos}), {repo} officielles, {aur} AUR, "
+        f"{record['duration_ms']} ms")
+    return status
+
+
+def stats():
+    checks = load_status().get("checks", [])
+    fetched = [c for c in checks if c["fetch"]]
+    total = sum(c["bytes"] for c in fetched)
+    print(json.dumps({
+        "checks": len(checks),
+        "fetches": len(fetched),
+        "bytes_total": total,
+        "bytes_avg": round(total / len(fetched)) if fetched else 0,
+        "last": checks[-5:],
+    }, indent=2, ensure_ascii=False))
+    return 0
+
+
+def main():
+    command = sys.argv[1] if len(sys.argv) > 1 else ""
+    if command == "module":
+        status = load_status() or check()
+    elif command == "check":
+        status = check(fetch_dbs="--no-fetch" not in sys.argv[2:])
+    elif command == "stats":
+        return stats()
+    else:
+        print(__doc__)
+        return 1
+    print(json.dumps(module_value(status), ensure_ascii=False))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
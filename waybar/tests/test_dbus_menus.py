@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+Tests des menus Wi-Fi et Bluetooth (network_manager.py, bluetooth_manager.py) contre des
+services NetworkManager et BlueZ simulés par python-dbusmock sur un bus système privé.
+
+Lancement : python3 -m unittest discover -s waybar/tests
+Dépendances : python-dbusmock, python-gobject
+"""
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+from unittest import mock
+
+from gi.repository import Gio, GLib
+
+try:
+    import dbus
+    import dbusmock
+except ImportError:
+    dbusmock = None
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "scripts"))
+import bluetooth_manager  # noqa: E402
+import network_manager  # noqa: E402
+
+NM = "org.freedesktop.NetworkManager"
+NM_PATH = "/org/freedesktop/NetworkManager"
+NM_SETTINGS_PATH = f"{NM_PATH}/Settings"
+WIFI_DEVICE = f"{NM_PATH}/Devices/1"
+ACCESS_POINT = f"{NM_PATH}/AccessPoint/1"
+SAVED_PROFILE = f"{NM_PATH}/Settings/1"
+NEW_PROFILE = f"{NM_PATH}/Settings/2"
+ACTIVE_OK = f"{NM_PATH}/ActiveConnection/1"
+ACTIVE_FAILED = f"{NM_PATH}/ActiveConnection/2"
+SSID = b"Maison"
+
+BLUEZ_DEVICE = "/org/bluez/hci0/dev_AA_BB_CC_DD_EE_FF"
+
+
+def ap_flags(flags=0, wpa=0, rsn=0):
+    return {"Flags": flags, "WpaFlags": wpa, "RsnFlags": rsn}
+
+
+class KeyMgmtTest(unittest.TestCase):
+    def test_key_mgmt_from_access_point_flags(self):
+        self.assertEqual(network_manager.key_mgmt(ap_flags()), "")
+        self.assertEqual(network_manager.key_mgmt(ap_flags(flags=0x1)), "none")
+        self.assertEqual(network_manager.key_mgmt(ap_flags(flags=0x1, wpa=0x100)), "wpa-psk")
+        self.assertEqual(network_manager.key_mgmt(ap_flags(flags=0x1, rsn=0x100)), "wpa-psk")
+        self.assertEqual(network_manager.key_mgmt(ap_flags(flags=0x1, rsn=0x400)), "sae")
+        # WPA3 en mode transition : wpa-psk fonctionne aussi avec les clients WPA2
+        self.assertEqual(network_manager.key_mgmt(ap_flags(flags=0x1, rsn=0x500)), "wpa-psk")
+        self.assertIsNone(network_manager.key_mgmt(ap_flags(flags=0x1, rsn=0x200)))
+
+
+class MockedBusTest(dbusmock.DBusTestCase if dbusmock else unittest.TestCase):
+    """Bus système privé ; les menus y accèdent par une connexion Gio dédiée"""
+
+    @classmethod
+    def setUpClass(cls):
+        if dbusmock is None:
+            raise unittest.SkipTest("python-dbusmock non installé")
+        super().setUpClass()
+        cls.start_system_bus()
+        cls.dbus_con = cls.get_dbus(system_bus=True)
+
+    def setUp(self):
+        self.mocks = []
+        self.log_dir = tempfile.TemporaryDirectory()
+        conn = Gio.DBusConnection.new_for_address_sync(
+            os.environ["DBUS_SYSTEM_BUS_ADDRESS"],
+            Gio.DBusConnectionFlags.AUTHENTICATION_CLIENT | Gio.DBusConnectionFlags.MESSAGE_BUS_CONNECTION,
+            None, None)
+        self.gio_conn = conn
+        patch = mock.patch.object(Gio, "bus_get_sync", lambda _bus_type, _cancellable: conn)
+        patch.start()
+        self.addCleanup(patch.stop)
+
+    def tearDown(self):
+        self.gio_conn.close_sync(None)
+        for process in self.mocks:
+            process.stdout.close()
+            process.terminate()
+            process.wait()
+        self.log_dir.cleanup()
+
+    def spawn(self, name, path, interface):
+        process = self.spawn_server(name, path, interface, system_bus=True, stdout=subprocess.PIPE)
+        self.mocks.append(process)
+        return dbus.Interface(self.dbus_con.get_object(name, path), dbusmock.MOCK_IFACE)
+
+    def mock_object(self, name, path):
+        return dbus.Interface(self.dbus_con.get_object(name, path), dbusmock.MOCK_IFACE)
+
+
+class NetworkManagerTest(MockedBusTest):
+    def setUp(self):
+        super().setUp()
+        network_manager.LOG_FILE = os.path.join(self.log_dir.name, "wifi.log")
+        network_manager.ACTIVATION_TIMEOUT = 5
+        self.notifications = []
+        for name, value in (("notify", lambda _title, message: self.notifications.append(message)),
+                            ("rofi_password", lambda _prompt: self.password)):
+            patch = mock.patch.object(network_manager, name, value)
+            patch.start()
+            self.addCleanup(patch.stop)
+        self.password = None
+
+        nm = self.spawn(NM, NM_PATH, NM)
+        nm.AddMethods(NM, [
+            ("GetDevices", "", "ao", f"ret = ['{WIFI_DEVICE}']"),
+            ("ActivateConnection", "ooo", "o", f"ret = '{ACTIVE_FAILED}'"),
+        ])
+        nm.AddObject(WIFI_DEVICE, f"{NM}.Device", {"DeviceType": dbus.UInt32(2)}, [])
+        nm.AddObject(NM_SETTINGS_PATH, f"{NM}.Settings", {}, [
+            ("ListConnections", "", "ao", f"ret = ['{SAVED_PROFILE}']"),
+        ])
+        settings = {"802-11-wireless": {"ssid": dbus.ByteArray(SSID)}}
+        for profile in (SAVED_PROFILE, NEW_PROFILE):
+            nm.AddObject(profile, f"{NM}.Settings.Connection", {}, [
+                ("GetSettings", "", "a{sa{sv}}", f"ret = {settings!r}"),
+                ("Delete", "", "", ""),
+            ])
+        nm.AddObject(ACTIVE_OK, f"{NM}.Connection.Active", {"State": dbus.UInt32(2)}, [])
+        nm.AddObject(ACTIVE_FAILED, f"{NM}.Connection.Active", {"State": dbus.UInt32(4)}, [])
+        self.nm_mock = nm
+        self.set_new_connection_result(ACTIVE_OK)
+
+    def set_new_connection_result(self, active):
+        self.nm_mock.AddMethod(NM, "AddAndActivateConnection", "a{sa{sv}}oo", "oo",
+                               f"ret = ('{NEW_PROFILE}', '{active}')")
+
+    def add_access_point(self, **flags):
+        self.nm_mock.AddObject(ACCESS_POINT, f"{NM}.AccessPoint", {
+            "Ssid": dbus.ByteArray(SSID), "Strength": dbus.Byte(70),
+            "Flags": dbus.UInt32(flags.get("flags", 0)), "WpaFlags": dbus.UInt32(flags.get("wpa", 0)),
+            "RsnFlags": dbus.UInt32(flags.get("rsn", 0)),
+        }, [])
+        nm = network_manager.NetworkManager()
+        return nm, nm.access_point(ACCESS_POINT)
+
+    def deleted(self, profile):
+        return len(self.mock_object(NM, profile).GetMethodCalls("Delete"))
+
+    def added_settings(self):
+        return [call[1][0] for call in self.nm_mock.GetMethodCalls("AddAndActivateConnection")]
+
+    def test_saved_profile_activates(self):
+        self.nm_mock.AddMethod(NM, "ActivateConnection", "ooo", "o", f"ret = '{ACTIVE_OK}'")
+        nm, ap = self.add_access_point(flags=0x1, rsn=0x100)
+        self.assertTrue(network_manager.connect(nm, ap))
+        self.assertEqual(self.added_settings(), [])
+
+    def test_cancelled_password_keeps_saved_profile(self):
+        nm, ap = self.add_access_point(flags=0x1, rsn=0x100)
+        self.assertFalse(network_manager.connect(nm, ap))
+        self.assertEqual(self.deleted(SAVED_PROFILE), 0)
+        self.assertEqual(self.added_settings(), [])
+
+    def test_saved_profile_replaced_once_new_one_is_connected(self):
+        self.password = "secret"
+        nm, ap = self.add_access_point(flags=0x1, rsn=0x400)
+        self.assertTrue(network_manager.connect(nm, ap))
+        [settings] = self.added_settings()
+        self.assertEqual(settings["802-11-wireless-security"]["key-mgmt"], "sae")
+        self.assertEqual(settings["802-11-wireless-security"]["psk"], "secret")
+        self.assertEqual(self.deleted(SAVED_PROFILE), 1)
+        self.assertEqual(self.deleted(NEW_PROFILE), 0)
+
+    def test_failed_new_profile_keeps_saved_profile(self):
+        self.password = "wrong"
+        self.set_new_connection_result(ACTIVE_FAILED)
+        nm, ap = self.add_access_point(flags=0x1, wpa=0x100)
+        self.assertFalse(network_manager.connect(nm, ap))
+        self.assertEqual(self.added_settings()[0]["802-11-wireless-security"]["key-mgmt"], "wpa-psk")
+        self.assertEqual(self.deleted(SAVED_PROFILE), 0)
+        self.assertEqual(self.deleted(NEW_PROFILE), 1)
+
+    def test_enterprise_network_is_not_prompted(self):
+        self.password = "unused"
+        nm, ap = self.add_access_point(flags=0x1, rsn=0x200)
+        self.assertFalse(network_manager.connect(nm, ap))
+        self.assertEqual(self.added_settings(), [])
+        self.assertEqual(self.deleted(SAVED_PROFILE), 0)
+        self.assertIn("802.1X", self.notifications[-1])
+
+
+class BluetoothAgentTest(MockedBusTest):
+    def setUp(self):
+        super().setUp()
+        bluetooth_manager.LOG_FILE = os.path.join(self.log_dir.name, "bluetooth.log")
+        bluez = self.spawn("org.bluez", "/org/bluez", "org.bluez.AgentManager1")
+        bluez.AddMethods("org.bluez.AgentManager1", [
+            ("RegisterAgent", "os", "", ""),
+            ("UnregisterAgent", "o", "", ""),
+        ])
+        # Comme bluetoothd, Pair interroge l'agent de l'appelant pendant l'appel
+        owner = self.gio_conn.get_unique_name()
+        confirm = (f"self.connection.call_blocking('{owner}', '{bluetooth_manager.AGENT_PATH}', "
+                   f"'org.bluez.Agent1', 'RequestConfirmation', 'ou', "
+                   f"[dbus.ObjectPath('{BLUEZ_DEVICE}'), dbus.UInt32(123456)], timeout=5)")
+        bluez.AddObject(BLUEZ_DEVICE, "org.bluez.Device1", {}, [("Pair", "", "", confirm)])
+        bluez.AddObject("/", "org.freedesktop.DBus.ObjectManager", {}, [
+            ("GetManagedObjects", "", "a{oa{sa{sv}}}", "ret = {}"),
+        ])
+        self.bluez_mock = bluez
+        self.bluez = bluetooth_manager.BlueZ()
+
+    def agent_calls(self):
+        return [(call[1], list(call[2])) for call in self.bluez_mock.GetCalls()]
+
+    def test_pair_registers_agent_that_answers_bluez(self):
+        self.bluez.device_call_with_agent({"path": BLUEZ_DEVICE}, "Pair")
+        self.assertEqual(len(self.mock_object("org.bluez", BLUEZ_DEVICE).GetMethodCalls("Pair")), 1)
+        self.assertEqual(self.agent_calls(), [
+            ("RegisterAgent", [bluetooth_manager.AGENT_PATH, "NoInputNoOutput"]),
+            ("UnregisterAgent", [bluetooth_manager.AGENT_PATH]),
+        ])
+
+    def test_agent_unregistered_when_pair_fails(self):
+        self.bluez_mock.AddObject(BLUEZ_DEVICE + "_2", "org.bluez.Device1", {}, [
+            ("Pair", "", "", "raise dbus.exceptions.DBusException('Authentication Failed', "
+                             "name='org.bluez.Error.AuthenticationFailed')"),
+        ])
+        with self.assertRaises(GLib.Error):
+            self.bluez.device_call_with_agent({"path": BLUEZ_DEVICE + "_2"}, "Pair")
+        self.assertEqual([name for name, _args in self.agent_calls()], ["RegisterAgent", "UnregisterAgent"])
+
+
+if __name__ == "__main__":
+    unittest.main()